@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "cpu_relax.hpp"
+#include "futex.hpp"
+#include "futex_condition_variable.hpp"
+#include "mutex_policy.hpp"
+
+namespace concurrent {
+    // Mutex spinning for a while before it parks the thread on a futex.
+    // How long it spins adapts to how long spinning recently needed to
+    // succeed, like glibc's adaptive mutex. Uncontended lock and unlock are
+    // a single atomic operation each, unlock makes a system call only if
+    // some thread is parked.
+    class adaptive_mutex {
+        static constexpr std::uint32_t unlocked = 0u;
+        static constexpr std::uint32_t locked = 1u;
+        static constexpr std::uint32_t locked_with_waiters = 2u;
+
+        futex_word m_state{unlocked};
+        std::atomic<int> m_spins_estimate{0};
+
+        bool try_acquire() noexcept {
+            auto expected = unlocked;
+            return m_state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void lock_contended() noexcept {
+            const int spin_limit = default_spin_limit();
+            const auto estimate = m_spins_estimate.load(std::memory_order_relaxed);
+            const auto limit = std::min(spin_limit, estimate * 2 + 10);
+
+            for (int spins = 0; spins < limit; ++spins) {
+                cpu_relax();
+                if (m_state.load(std::memory_order_relaxed) == unlocked && try_acquire()) {
+                    m_spins_estimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            m_spins_estimate.store(estimate + (limit - estimate) / 8, std::memory_order_relaxed);
+
+            while (m_state.exchange(locked_with_waiters, std::memory_order_acquire) != unlocked) {
+                futex_wait(m_state, locked_with_waiters);
+            }
+        }
+
+    public:
+        adaptive_mutex() = default;
+        adaptive_mutex(const adaptive_mutex &) = delete;
+        adaptive_mutex &operator=(const adaptive_mutex &) = delete;
+
+        void lock() noexcept {
+            if (!try_acquire()) {
+                lock_contended();
+            }
+        }
+
+        bool try_lock() noexcept {
+            return try_acquire();
+        }
+
+        void unlock() noexcept {
+            if (m_state.exchange(unlocked, std::memory_order_release) == locked_with_waiters) {
+                futex_wake_one(m_state);
+            }
+        }
+    };
+
+    template <>
+    struct condition_variable_for<adaptive_mutex> {
+        using type = futex_condition_variable;
+    };
+}
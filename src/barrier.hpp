@@ -1,54 +1,141 @@
 #pragma once
 
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "cpu_relax.hpp"
+#include "futex.hpp"
 
 namespace concurrent {
+    // Number of the current phase of a barrier. Threads wait for it to
+    // change spinning for a while first, then parked on a futex. Changing
+    // the phase makes a system call only if some thread is parked.
+    class barrier_phase {
+        futex_word m_phase{0u};
+        std::atomic<std::uint32_t> m_parked{0u};
 
+    public:
+        std::uint32_t current() const noexcept {
+            return m_phase.load(std::memory_order_acquire);
+        }
+
+        void wait(std::uint32_t phase) noexcept {
+            for (auto spins = default_spin_limit(); spins > 0u; --spins) {
+                if (current() != phase) {
+                    return;
+                }
+                cpu_relax();
+            }
+
+            while (current() == phase) {
+                m_parked.fetch_add(1u);
+                futex_wait(m_phase, phase);
+                m_parked.fetch_sub(1u, std::memory_order_relaxed);
+            }
+        }
+
+        // Returns false if the phase didn't change before the deadline.
+        template <class Clock, class Duration>
+        bool wait_until(std::uint32_t phase, const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+            while (current() == phase) {
+                const auto timeout = deadline - Clock::now();
+                if (timeout <= timeout.zero()) {
+                    return false;
+                }
+
+                m_parked.fetch_add(1u);
+                futex_wait_for(m_phase, phase, timeout);
+                m_parked.fetch_sub(1u, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        void advance() noexcept {
+            m_phase.fetch_add(1u);
+            if (m_parked.load() > 0u) {
+                futex_wake_all(m_phase);
+            }
+        }
+    };
+
+    // Reusable barrier: once `count` threads arrived, the optional
+    // completion function is called by the last of them, all of them are
+    // released and the barrier is ready for the next phase.
+    //
+    // A thread whose `wait_for` timed out stays counted as arrived in
+    // the phase it waited for. Unlike a single-use barrier, waits after
+    // a completed phase block until the next one. Barrier for no threads,
+    // e.g. after all of them dropped, doesn't block.
     class barrier {
-        std::mutex m_mutex;
-        std::condition_variable m_cv;
-        std::size_t m_count;
+        std::atomic<std::size_t> m_expected;
+        std::atomic<std::size_t> m_remaining;
+        barrier_phase m_phase;
+        std::function<void()> m_completion;
+
+        // Returns phase the thread arrived at, phase is already completed
+        // if the thread was the last one.
+        std::uint32_t arrive() {
+            const auto phase = m_phase.current();
+            if (m_remaining.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+                if (m_completion) {
+                    m_completion();
+                }
+                m_remaining.store(m_expected.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                m_phase.advance();
+            }
+            return phase;
+        }
+
+        bool empty() const noexcept {
+            return m_expected.load(std::memory_order_relaxed) == 0u;
+        }
 
     public:
-        explicit barrier(std::size_t count) :
-                m_count{count} {
+        explicit barrier(std::size_t count, std::function<void()> completion = std::function<void()>()):
+                m_expected{count},
+                m_remaining{count},
+                m_phase(),
+                m_completion(std::move(completion)) {
 
         }
 
+        // Copies only the number of threads and the completion function,
+        // barrier mustn't be in use.
         barrier(const barrier &second):
-            m_count(second.m_count) {
+                barrier(second.m_expected.load(), second.m_completion) {
 
         }
 
         void wait() {
-            std::unique_lock<std::mutex> lock{m_mutex};
-            if (m_count > 0) {
-                --m_count;
-            }
-
-            if (m_count == 0) {
-                m_cv.notify_all();
-            } else {
-                m_cv.wait(lock, [this] { return m_count == 0; });
+            if (empty()) {
+                return;
             }
+            const auto phase = arrive();
+            m_phase.wait(phase);
         }
 
         template<typename _Rep, typename _Period>
         bool wait_for(const std::chrono::duration<_Rep, _Period> &time) {
-            std::unique_lock<std::mutex> lock{m_mutex};
-            if (m_count > 0) {
-                --m_count;
-            }
-
-            if (m_count == 0) {
-                m_cv.notify_all();
+            if (empty()) {
                 return true;
-            } else {
-                return m_cv.wait_for(lock, time, [this] { return m_count == 0; });
             }
+            const auto deadline = std::chrono::steady_clock::now() + time;
+            const auto phase = arrive();
+            return m_phase.wait_until(phase, deadline);
+        }
+
+        // Arrives at the current phase and leaves the barrier, following
+        // phases wait for one thread less. Does nothing if no thread is
+        // left.
+        void arrive_and_drop() {
+            auto expected = m_expected.load(std::memory_order_relaxed);
+            do {
+                if (expected == 0u) {
+                    return;
+                }
+            } while (!m_expected.compare_exchange_weak(expected, expected - 1u, std::memory_order_relaxed));
+            arrive();
         }
     };
 }
-
-
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace concurrent {
+    // Implemented by task queues which compensate for their workers blocked
+    // in a `blocking_section`. `end_blocking` is called even if
+    // `begin_blocking` threw.
+    class blocking_handler {
+    public:
+        virtual void begin_blocking() = 0;
+        virtual void end_blocking() = 0;
+
+    protected:
+        ~blocking_handler() = default;
+    };
+
+    // Handler of the task queue whose worker is the calling thread.
+    inline blocking_handler *&current_blocking_handler() noexcept {
+        static thread_local blocking_handler *handler = nullptr;
+        return handler;
+    }
+
+    // Marks a scope in which a task blocks, e.g. on I/O. If the calling
+    // thread is a worker of a task queue which supports it, the queue runs
+    // a compensating worker until the scope is left, so other tasks don't
+    // wait behind the blocked one. Elsewhere it does nothing. If the queue
+    // fails to start a compensating worker, the task blocks without one.
+    class blocking_section {
+        blocking_handler *const m_handler;
+
+    public:
+        blocking_section() noexcept:
+                m_handler(current_blocking_handler()) {
+            if (m_handler != nullptr) {
+                try {
+                    m_handler->begin_blocking();
+                } catch (...) {
+                    // `end_blocking` is still called, handlers count the
+                    // blocked worker before they fail
+                }
+            }
+        }
+
+        blocking_section(const blocking_section &) = delete;
+        blocking_section &operator=(const blocking_section &) = delete;
+
+        ~blocking_section() {
+            if (m_handler != nullptr) {
+                m_handler->end_blocking();
+            }
+        }
+    };
+}
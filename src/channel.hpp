@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include "lightweight_semaphore.hpp"
+#include "mpmc_ring.hpp"
+#include "spsc_ring.hpp"
+#include "semaphore.hpp"
+
+namespace concurrent {
+    // Bounded channel passing values between threads. Values are stored in
+    // a lock-free `Ring`, free slots and stored values are counted by
+    // lightweight semaphores, so threads park on `Semaphore` only when the
+    // channel is full or empty.
+    //
+    // After `close` sends fail, receiving returns values which were sent
+    // before and then fails as well. Blocked senders and receivers are
+    // woken up.
+    template <class T, class Ring = mpmc_ring<T>, class Semaphore = semaphore>
+    class channel {
+        // permits released on close, so nobody parks anymore
+        static constexpr unsigned closed_permits = 1u << 30u;
+        static constexpr std::size_t closed_flag = 1u;
+        static constexpr std::size_t sender = 2u;
+
+        Ring m_ring;
+        const std::size_t m_capacity;
+        lightweight_semaphore<Semaphore> m_free_slots;
+        lightweight_semaphore<Semaphore> m_values;
+        // senders in progress times `sender`, plus `closed_flag`
+        std::atomic<std::size_t> m_state{0u};
+
+        bool begin_send() noexcept {
+            if (m_state.fetch_add(sender) & closed_flag) {
+                end_send();
+                return false;
+            }
+            return true;
+        }
+
+        void end_send() noexcept {
+            m_state.fetch_sub(sender);
+        }
+
+        // Called with acquired free slot.
+        template <class U>
+        bool finish_send(U &&value) {
+            if (closed()) {
+                end_send();
+                return false;
+            }
+
+            // slot can still be occupied by a consumer finishing its pop
+            while (!m_ring.try_push(std::forward<U>(value))) {
+                std::this_thread::yield();
+            }
+            m_values.release();
+            end_send();
+            return true;
+        }
+
+        // Called with acquired value, or on closed channel. Fails only if
+        // the channel is closed and empty.
+        bool pop(T &value) {
+            while (!m_ring.try_pop(value)) {
+                if (m_state.load() == closed_flag) {
+                    return m_ring.try_pop(value);
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        template <class OutputIt>
+        std::size_t finish_recv_batch(OutputIt output, std::size_t count) {
+            std::size_t received = 0u;
+            T value;
+            while (received < count && pop(value)) {
+                *output = std::move(value);
+                ++output;
+                ++received;
+            }
+            m_free_slots.release(static_cast<unsigned>(received));
+            return received;
+        }
+
+        bool finish_recv(T &value) {
+            if (!pop(value)) {
+                return false;
+            }
+            m_free_slots.release();
+            return true;
+        }
+
+        static unsigned batch_permits(std::size_t count) noexcept {
+            const unsigned limit = closed_permits;
+            return count < limit ? static_cast<unsigned>(count) : limit;
+        }
+
+    public:
+        using value_type = T;
+
+        explicit channel(std::size_t capacity):
+                m_ring(capacity),
+                m_capacity(capacity),
+                m_free_slots(static_cast<unsigned>(capacity)),
+                m_values(0u) {
+
+        }
+
+        channel(const channel &) = delete;
+        channel &operator=(const channel &) = delete;
+
+        std::size_t capacity() const noexcept {
+            return m_capacity;
+        }
+
+        bool closed() const noexcept {
+            return (m_state.load() & closed_flag) != 0u;
+        }
+
+        void close() {
+            if ((m_state.fetch_or(closed_flag) & closed_flag) == 0u) {
+                m_free_slots.release(closed_permits);
+                m_values.release(closed_permits);
+            }
+        }
+
+        // Blocks while the channel is full, fails if it's closed. Value is
+        // moved from only if it was sent.
+        template <class U>
+        bool send(U &&value) {
+            if (!begin_send()) {
+                return false;
+            }
+            m_free_slots.acquire();
+            return finish_send(std::forward<U>(value));
+        }
+
+        template <class U>
+        bool try_send(U &&value) {
+            if (!begin_send()) {
+                return false;
+            }
+            if (!m_free_slots.try_acquire()) {
+                end_send();
+                return false;
+            }
+            return finish_send(std::forward<U>(value));
+        }
+
+        template <class U, class Duration>
+        bool try_send_for(U &&value, const Duration &duration) {
+            if (!begin_send()) {
+                return false;
+            }
+            if (!m_free_slots.try_acquire_for(duration)) {
+                end_send();
+                return false;
+            }
+            return finish_send(std::forward<U>(value));
+        }
+
+        // Blocks while the channel is empty, fails if it's closed and
+        // empty.
+        bool recv(T &value) {
+            if (!closed()) {
+                m_values.acquire();
+            }
+            return finish_recv(value);
+        }
+
+        bool try_recv(T &value) {
+            if (!closed() && !m_values.try_acquire()) {
+                return false;
+            }
+            return finish_recv(value);
+        }
+
+        template <class Duration>
+        bool try_recv_for(T &value, const Duration &duration) {
+            if (!closed() && !m_values.try_acquire_for(duration)) {
+                return false;
+            }
+            return finish_recv(value);
+        }
+
+        // Blocks until at least one value is available and receives up to
+        // `max_count` values to `output`, returns their number, which is 0
+        // only if the channel is closed and empty.
+        template <class OutputIt>
+        std::size_t recv_batch(OutputIt output, std::size_t max_count) {
+            if (max_count == 0u) {
+                return 0u;
+            }
+            if (closed()) {
+                return finish_recv_batch(output, max_count);
+            }
+
+            m_values.acquire();
+            const auto available = 1u + m_values.try_acquire_up_to(batch_permits(max_count - 1u));
+            return finish_recv_batch(output, available);
+        }
+
+        // Receives up to `max_count` values which are available right away.
+        template <class OutputIt>
+        std::size_t try_recv_batch(OutputIt output, std::size_t max_count) {
+            if (closed()) {
+                return finish_recv_batch(output, max_count);
+            }
+            return finish_recv_batch(output, m_values.try_acquire_up_to(batch_permits(max_count)));
+        }
+    };
+
+    template <class T, class Semaphore = semaphore>
+    using spsc_channel = channel<T, spsc_ring<T>, Semaphore>;
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <utility>
+#include "stamped_queue.hpp"
+#include "stamped_task.hpp"
+#include "trace_ring.hpp"
+#include "worker_slots.hpp"
+
+namespace concurrent {
+    // Instrumentation policy recording lifecycle of every task: when it was
+    // enqueued, started and finished, by which worker, with optional label
+    // given with `stamped_task`. Tasks are stamped with the time they're
+    // pushed, queues of plain `std::function` tasks store them as
+    // `stamped_task` for it. Every worker writes to its own ring buffer,
+    // queue depth is sampled on every push into a ring guarded by the queue
+    // lock, with the time the pushed task was stamped. Recorded events can
+    // be dumped at any time as Chrome trace JSON, readable by
+    // chrome://tracing and Perfetto.
+    class chrome_tracing {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        template <class Queue>
+        using stored_queue = stamped_queue_t<Queue>;
+
+    private:
+        // enqueue time, start time, end time, label
+        using task_ring = trace_ring<4u>;
+        // time, queue depth
+        using depth_ring = trace_ring<2u>;
+
+        const clock_type::time_point m_epoch;
+        const std::size_t m_events_per_worker;
+        worker_slots<task_ring> m_slots;
+        depth_ring m_queue_depth;
+
+        static clock_type::time_point &stamp_time() noexcept {
+            static thread_local clock_type::time_point time;
+            return time;
+        }
+
+        std::uint64_t since_epoch(clock_type::time_point time) const noexcept {
+            if (time <= m_epoch) {
+                return 0u;
+            }
+
+            return static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_epoch).count()
+            );
+        }
+
+    public:
+        class worker_probe {
+            chrome_tracing *m_tracing;
+            std::size_t m_index;
+            task_ring *m_ring;
+            std::uint64_t m_enqueue_time;
+            std::uint64_t m_start_time;
+            std::uint64_t m_end_time;
+            const char *m_label;
+            // a task taken without waiting starts when the previous one
+            // ended, so the clock is read once between them
+            bool m_waited;
+
+        public:
+            worker_probe() noexcept:
+                    m_tracing(nullptr),
+                    m_index(0u),
+                    m_ring(nullptr),
+                    m_enqueue_time(0u),
+                    m_start_time(0u),
+                    m_end_time(0u),
+                    m_label(nullptr),
+                    m_waited(true) {
+
+            }
+
+            worker_probe(chrome_tracing &tracing, std::size_t index) noexcept:
+                    m_tracing(&tracing),
+                    m_index(index),
+                    m_ring(&tracing.m_slots[index]),
+                    m_enqueue_time(0u),
+                    m_start_time(0u),
+                    m_end_time(0u),
+                    m_label(nullptr),
+                    m_waited(true) {
+
+            }
+
+            worker_probe(worker_probe &&other) noexcept:
+                    m_tracing(other.m_tracing),
+                    m_index(other.m_index),
+                    m_ring(other.m_ring),
+                    m_enqueue_time(other.m_enqueue_time),
+                    m_start_time(other.m_start_time),
+                    m_end_time(other.m_end_time),
+                    m_label(other.m_label),
+                    m_waited(other.m_waited) {
+                other.m_ring = nullptr;
+            }
+
+            worker_probe(const worker_probe &) = delete;
+            worker_probe &operator=(const worker_probe &) = delete;
+
+            ~worker_probe() {
+                if (m_ring) {
+                    m_tracing->m_slots.release(m_index);
+                }
+            }
+
+            void on_wait() noexcept {
+                m_waited = true;
+            }
+
+            template <class Task>
+            void on_task_begin(const Task &task) noexcept {
+                if (!m_ring) {
+                    return;
+                }
+
+                m_enqueue_time = m_tracing->since_epoch(task_enqueue_time(task));
+                // the task may have been pushed after the previous one ended
+                m_start_time = m_waited
+                               ? m_tracing->since_epoch(clock_type::now())
+                               : std::max(m_end_time, m_enqueue_time);
+                m_label = task_label(task);
+                m_waited = false;
+            }
+
+            void on_task_end() noexcept {
+                if (!m_ring) {
+                    return;
+                }
+
+                m_end_time = m_tracing->since_epoch(clock_type::now());
+                m_ring->push({
+                        m_enqueue_time,
+                        m_start_time,
+                        m_end_time,
+                        static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(m_label))
+                });
+            }
+        };
+
+        // Every worker keeps `events_per_worker` latest tasks, queue depth
+        // is kept for `queue_depth_samples` latest pushes.
+        explicit chrome_tracing(
+                std::size_t events_per_worker = 4096u,
+                std::size_t queue_depth_samples = 4096u,
+                std::size_t max_workers = 1024u
+        ):
+                m_epoch(clock_type::now()),
+                m_events_per_worker(events_per_worker),
+                m_slots(max_workers),
+                m_queue_depth(queue_depth_samples) {
+
+        }
+
+        chrome_tracing(const chrome_tracing &) = delete;
+        chrome_tracing &operator=(const chrome_tracing &) = delete;
+
+        worker_probe make_worker_probe() {
+            const auto index = m_slots.acquire(m_events_per_worker);
+            if (index == m_slots.capacity()) {
+                return worker_probe();
+            }
+
+            return worker_probe(*this, index);
+        }
+
+        // The time the element is stamped with is kept for the depth sample
+        // of the enqueue which follows on the same thread, so the clock is
+        // read once per push.
+        template <class Element>
+        decltype(auto) stamp(Element &&element) {
+            const auto now = clock_type::now();
+            stamp_time() = now;
+            return stamp_task(std::forward<Element>(element), now);
+        }
+
+        // Enqueues of elements, which weren't stamped on this thread, e.g.
+        // staged ones moved by workers, read the clock.
+        template <class Queue>
+        void on_enqueue(const Queue &queue) noexcept {
+            auto &stamped = stamp_time();
+            const auto time = stamped != clock_type::time_point() ? stamped : clock_type::now();
+            stamped = clock_type::time_point();
+            m_queue_depth.push({since_epoch(time), queue.size()});
+        }
+
+        void write_chrome_trace(std::ostream &stream) const {
+            const auto write_timestamp = [&stream](std::uint64_t nanoseconds) {
+                stream << nanoseconds / 1000u << '.';
+                const auto fraction = nanoseconds % 1000u;
+                stream << fraction / 100u << fraction / 10u % 10u << fraction % 10u;
+            };
+
+            const auto write_label = [&stream](std::uint64_t label) {
+                const auto text = reinterpret_cast<const char *>(static_cast<std::uintptr_t>(label));
+                if (!text) {
+                    stream << "task";
+                    return;
+                }
+
+                for (auto c = text; *c; ++c) {
+                    if (*c == '"' || *c == '\\') {
+                        stream << '\\' << *c;
+                    } else if (static_cast<unsigned char>(*c) >= 0x20u) {
+                        stream << *c;
+                    }
+                }
+            };
+
+            std::uint64_t flow_id = 0u;
+            const char *separator = "\n";
+            stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+            const auto slots_count = m_slots.size();
+            for (auto worker = 0u; worker < slots_count; ++worker) {
+                stream << separator
+                       << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << worker
+                       << ",\"args\":{\"name\":\"worker " << worker << "\"}}";
+                separator = ",\n";
+
+                m_slots[worker].for_each([&](const task_ring::entry_type &entry) {
+                    const auto enqueue_time = entry[0];
+                    const auto start_time = entry[1];
+                    const auto end_time = entry[2];
+
+                    stream << separator << "{\"name\":\"";
+                    write_label(entry[3]);
+                    stream << "\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":" << worker << ",\"ts\":";
+                    write_timestamp(start_time);
+                    stream << ",\"dur\":";
+                    write_timestamp(end_time - start_time);
+                    stream << "}";
+
+                    if (enqueue_time != 0u) {
+                        ++flow_id;
+                        for (auto phase: {"b", "e"}) {
+                            stream << separator << "{\"name\":\"";
+                            write_label(entry[3]);
+                            stream << "\",\"cat\":\"queue\",\"ph\":\"" << phase
+                                   << "\",\"id\":" << flow_id << ",\"pid\":1,\"tid\":" << worker << ",\"ts\":";
+                            write_timestamp(*phase == 'b' ? enqueue_time : start_time);
+                            stream << "}";
+                        }
+                    }
+                });
+            }
+
+            m_queue_depth.for_each([&](const depth_ring::entry_type &entry) {
+                stream << separator << "{\"name\":\"queue depth\",\"ph\":\"C\",\"pid\":1,\"ts\":";
+                write_timestamp(entry[0]);
+                stream << ",\"args\":{\"depth\":" << entry[1] << "}}";
+                separator = ",\n";
+            });
+
+            stream << "\n]}\n";
+        }
+
+        bool write_chrome_trace(const std::string &path) const {
+            std::ofstream file(path);
+            write_chrome_trace(file);
+            return static_cast<bool>(file);
+        }
+    };
+}
+
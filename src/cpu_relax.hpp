@@ -0,0 +1,42 @@
+#pragma once
+
+#include <thread>
+
+namespace concurrent {
+    // Hint for the processor that the thread is spinning.
+    inline void cpu_relax() noexcept {
+#if defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Spinning only wastes the time slice of the thread, which is going to
+    // release the lock, if there is a single processor.
+    inline unsigned default_spin_limit() noexcept {
+        static const unsigned limit = std::thread::hardware_concurrency() > 1u ? 100u : 0u;
+        return limit;
+    }
+
+    // Spins with `cpu_relax` for the first `spin_limit` calls, then yields.
+    class spin_backoff {
+        const unsigned m_spin_limit;
+        unsigned m_spins{0u};
+
+    public:
+        explicit spin_backoff(unsigned spin_limit = default_spin_limit()) noexcept:
+                m_spin_limit(spin_limit) {
+
+        }
+
+        void operator()() noexcept {
+            if (m_spins < m_spin_limit) {
+                ++m_spins;
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    };
+}
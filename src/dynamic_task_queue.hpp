@@ -1,41 +1,123 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <condition_variable>
 #include <future>
 #include <type_traits>
+#include <iterator>
+#include <chrono>
 #include "worker.hpp"
 #include "workers_pool.hpp"
-#include "infinite_waiting_strategy.hpp"
+#include "optional_timeout_waiting_strategy.hpp"
 #include "task_queue_base.hpp"
 #include "timeout_waiting_strategy.hpp"
 
 namespace concurrent {
-    template <class Queue, class Thread, class Semaphore = semaphore, class Duration = std::chrono::milliseconds>
-    class dynamic_task_queue: public task_queue_base<Queue, Semaphore> {
+    template <
+            class Queue,
+            class Thread,
+            class Semaphore = semaphore,
+            class Duration = std::chrono::milliseconds,
+            class Instrumentation = no_instrumentation,
+            class Mutex = std::mutex
+    >
+    class dynamic_task_queue: public task_queue_base<Queue, Semaphore, Instrumentation, Mutex> {
+        using base_type = task_queue_base<Queue, Semaphore, Instrumentation, Mutex>;
+
     public:
-        using queue_type = Queue;
-        using pushed_value_type = typename Queue::pushed_value_type;
+        using queue_type = typename base_type::queue_type;
+        using pushed_value_type = typename base_type::pushed_value_type;
+        using staging_lane = typename base_type::staging_lane;
+        using condition_variable_type = typename base_type::condition_variable_type;
         using thread_type = Thread;
         using worker_type = concurrent::worker<
                 queue_type,
-                concurrent::infinite_waiting_strategy,
+                concurrent::optional_timeout_waiting_strategy<Duration>,
                 thread_type,
-                Semaphore
+                Semaphore,
+                Instrumentation,
+                Mutex
         >;
         using dynamic_worker_type = concurrent::worker<
                 queue_type,
                 concurrent::timeout_waiting_strategy<Duration>,
                 thread_type,
-                Semaphore
+                Semaphore,
+                Instrumentation,
+                Mutex
         >;
 
     private:
+        // Spare workers are parked until a push which would spawn a dynamic
+        // worker hands its tasks over to one of them instead. Then they run
+        // tasks like dynamic workers, until they time out. With an idle
+        // timeout for core workers, parked spares time out after it as well,
+        // so an idle queue keeps no workers.
+        class spare_waiting_strategy {
+            dynamic_task_queue *m_task_queue;
+            bool m_parked{true};
+
+        public:
+            explicit spare_waiting_strategy(dynamic_task_queue *task_queue) noexcept:
+                    m_task_queue(task_queue) {
+
+            }
+
+            template < class ConditionVariable, class Lock, class Predicate >
+            bool operator()(
+                    ConditionVariable &condition_variable,
+                    Lock &lock,
+                    Predicate &&predicate
+            ) {
+                if (m_parked) {
+                    const auto handed_off = [this] {
+                        return m_task_queue->m_hand_offs > 0u || m_task_queue->m_stop_spares;
+                    };
+                    if (m_task_queue->m_core_timeout == Duration::zero()) {
+                        m_task_queue->m_spares_handed_off.wait(lock, handed_off);
+                    } else if (!m_task_queue->m_spares_handed_off.wait_for(lock, m_task_queue->m_core_timeout, handed_off)) {
+                        --m_task_queue->m_parked_spares;
+                        m_task_queue->m_spares_timed_out = true;
+                        return false;
+                    }
+                    if (m_task_queue->m_stop_spares) {
+                        return false;
+                    }
+                    --m_task_queue->m_hand_offs;
+                    m_parked = false;
+                }
+
+                return condition_variable.wait_for(lock, m_task_queue->m_timeout, std::forward<Predicate>(predicate));
+            }
+        };
+
+        using spare_worker_type = concurrent::worker<
+                queue_type,
+                spare_waiting_strategy,
+                thread_type,
+                Semaphore,
+                Instrumentation,
+                Mutex
+        >;
+
         concurrent::workers_list<worker_type> m_core_workers;
         concurrent::workers_list<dynamic_worker_type> m_dynamic_workers;
+        concurrent::workers_list<spare_worker_type> m_spare_workers;
         const std::size_t m_core_workers_size;
+        const std::size_t m_spare_workers_size;
+        // dynamic and spare workers together
         const std::size_t m_dynamic_workers_max_size;
         const Duration m_timeout;
+        const Duration m_core_timeout;
         const std::size_t m_max_queue_length;
+        std::size_t m_requested_core_workers{0u};
+        std::size_t m_requested_dynamic_workers{0u};
+        std::size_t m_parked_spares{0u};
+        std::size_t m_hand_offs{0u};
+        // parked spares aren't replaced after they timed out, until a push
+        bool m_spares_timed_out{false};
+        bool m_stop_spares{false};
+        condition_variable_type m_spares_handed_off;
         std::atomic_bool m_stop_cleaning{false};
         thread_type m_cleaning_thread;
 
@@ -45,62 +127,135 @@ namespace concurrent {
                 std::size_t max_pool_size = std::thread::hardware_concurrency() * 2,
                 Duration timeout = std::chrono::milliseconds(100),
                 std::size_t max_queue_length = 1u,
-                queue_type queue = queue_type()
+                queue_type queue = queue_type(),
+                std::size_t spare_pool_size = 0u,
+                Duration core_timeout = Duration::zero(),
+                std::size_t capacity = unbounded_capacity
         ):
-                task_queue_base<Queue, Semaphore>(std::move(queue)),
+                base_type(std::move(queue), capacity),
                 m_core_workers(),
                 m_dynamic_workers(),
+                m_spare_workers(),
                 m_core_workers_size(core_pool_size),
+                m_spare_workers_size(std::min(spare_pool_size, max_pool_size - core_pool_size)),
                 m_dynamic_workers_max_size(max_pool_size - core_pool_size),
                 m_timeout(std::move(timeout)),
+                m_core_timeout(std::move(core_timeout)),
                 m_max_queue_length(max_queue_length),
                 m_cleaning_thread{[this]{cleaning_thread();}} {
 
         }
 
+        // Blocks while the queue is full.
         void push(const pushed_value_type &element) {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.push(element);
-                if (!conditionally_increase_core_workers_size()) {
-                    conditionally_increase_dynamic_workers_size();
-                }
-            }
-            this->m_queue_not_empty.notify_one();
+            decltype(auto) stamped = this->stamp(element);
+            enqueue(locked(), this->wait_for_room(), this->pushing(stamped));
         }
 
         void push(pushed_value_type &&element) override {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.push(std::move(element));
-                if (!conditionally_increase_core_workers_size()) {
-                    conditionally_increase_dynamic_workers_size();
-                }
-            }
-            this->m_queue_not_empty.notify_one();
+            decltype(auto) stamped = this->stamp(std::move(element));
+            enqueue(locked(), this->wait_for_room(), this->pushing(std::move(stamped)));
         }
 
         template< class... Args >
         void emplace( Args&&... args ) {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.emplace(std::forward<Args>(args)...);
-                if (!conditionally_increase_core_workers_size()) {
-                    conditionally_increase_dynamic_workers_size();
+            // stamped task is constructed before the queue mutex is locked
+            if (this->stamps_elements) {
+                push(pushed_value_type(std::forward<Args>(args)...));
+                return;
+            }
+            enqueue(
+                    locked(),
+                    this->wait_for_room(),
+                    [&](queue_type &queue) { queue.emplace(std::forward<Args>(args)...); }
+            );
+        }
+
+        // Never blocks, fails if the queue is full or its mutex is locked.
+        // Element is moved from only if it was pushed.
+        bool try_push(const pushed_value_type &element) {
+            decltype(auto) stamped = this->stamp(element);
+            return enqueue(try_locked(), this->has_room(), this->pushing(stamped));
+        }
+
+        bool try_push(pushed_value_type &&element) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            const auto accepted = enqueue(try_locked(), this->has_room(), this->pushing(std::move(stamped)));
+            if (!accepted) {
+                this->give_back(element, stamped);
+            }
+            return accepted;
+        }
+
+        // Never blocks, if the queue mutex is locked or the queue is full,
+        // the element is staged in producer's own `lane` instead. Fails only
+        // if the lane is full. Staged elements are moved to the queue by the
+        // next push with the lane, which gets the mutex, or by `flush`. If
+        // the lane is registered, workers move them as well, when they look
+        // for their next task. A worker which started waiting just as the
+        // element was staged finds it only after `poll_interval()`, 5 ms.
+        // Staging doesn't allocate, but pushing to the underlying queue,
+        // here or when staged elements are moved, may, e.g. to a deque.
+        bool try_push(staging_lane &lane, pushed_value_type &&element) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            auto lock = try_locked();
+            if (!lock.owns_lock()) {
+                if (!lane.try_push(std::move(stamped))) {
+                    this->give_back(element, stamped);
+                    return false;
                 }
+                this->staged();
+                this->m_queue_not_empty.notify_one();
+                this->m_worker_exited.notify_one();
+                return true;
+            }
+
+            const auto size = this->m_task_queue.size();
+            auto accepted = true;
+            if (this->unstage(lane) && !this->full()) {
+                this->m_task_queue.push(std::move(stamped));
+                this->m_instrumentation.on_enqueue(this->m_task_queue);
+            } else {
+                accepted = lane.try_push(std::move(stamped));
             }
-            this->m_queue_not_empty.notify_one();
+            this->pushed(lock, this->m_task_queue.size() - size);
+            if (!accepted) {
+                this->give_back(element, stamped);
+            }
+            return accepted;
+        }
+
+        // Moves elements staged in `lane` to the queue while it has room.
+        void flush(staging_lane &lane) {
+            auto lock = locked();
+            const auto size = this->m_task_queue.size();
+            this->unstage(lane);
+            this->pushed(lock, this->m_task_queue.size() - size);
+        }
+
+        // Fails if the queue is still full after `duration`.
+        template <class Rep, class Period>
+        bool try_push_for(const pushed_value_type &element, const std::chrono::duration<Rep, Period> &duration) {
+            decltype(auto) stamped = this->stamp(element);
+            return enqueue(locked(), this->wait_for_room_for(duration), this->pushing(stamped));
+        }
+
+        template <class Rep, class Period>
+        bool try_push_for(pushed_value_type &&element, const std::chrono::duration<Rep, Period> &duration) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            const auto accepted = enqueue(locked(), this->wait_for_room_for(duration), this->pushing(std::move(stamped)));
+            if (!accepted) {
+                this->give_back(element, stamped);
+            }
+            return accepted;
         }
 
         void wait_for_tasks_completion() {
             static_assert(!is_semaphore_fake<Semaphore>::value, "Cannot wait for finished task with fake semaphore!");
-            std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-            this->m_queue_empty.wait(lock, [this]{ return this->m_task_queue.empty(); });
-            const auto workers_size = this->m_core_workers.size() + this->m_dynamic_workers.size();
-            this->m_semaphore.acquire(workers_size);
-
-            //semaphore was acquired - all task were finished, we need to release it now to allow further execution
-            this->m_semaphore.release(workers_size);
+            this->wait_for_idle_workers(
+                    [this] { return m_core_workers.size() + m_dynamic_workers.size() + m_spare_workers.size(); },
+                    [] { return false; }
+            );
         }
 
         ~dynamic_task_queue() {
@@ -108,7 +263,7 @@ namespace concurrent {
 
             // to close cleaning thread
             {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
+                const auto lock = lock_at(this->m_queue_mutex, lock_site::cleaning_thread);
                 m_stop_cleaning = true;
             }
             this->m_worker_exited.notify_one();
@@ -116,34 +271,207 @@ namespace concurrent {
 
             m_core_workers.stop();
             m_dynamic_workers.stop();
+            m_spare_workers.stop();
+            {
+                const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                m_stop_spares = true;
+            }
 
             // wake all workers to be able to join their threads in destructor
             this->m_queue_not_empty.notify_all();
+            m_spares_handed_off.notify_all();
+        }
+
+    protected:
+        // Pushes by calling `operation` on the queue, e.g. to get a handle of
+        // the pushed element. Blocks while the queue is full.
+        template <class Operation>
+        void push_with(Operation &&operation) {
+            enqueue(locked(), this->wait_for_room(), std::forward<Operation>(operation));
         }
 
     private:
-        bool conditionally_increase_core_workers_size() {
-            if (m_core_workers.size() < m_core_workers_size) {
-                m_core_workers.emplace_back(
+        std::unique_lock<Mutex> locked() {
+            return lock_at(this->m_queue_mutex, lock_site::push);
+        }
+
+        std::unique_lock<Mutex> try_locked() {
+            return try_lock_at(this->m_queue_mutex, lock_site::push);
+        }
+
+        template <class Room, class Operation>
+        bool enqueue(std::unique_lock<Mutex> lock, Room &&room, Operation &&operation) {
+            if (!lock.owns_lock() || !room(lock)) {
+                return false;
+            }
+            operation(this->m_task_queue);
+            this->m_instrumentation.on_enqueue(this->m_task_queue);
+            pushed(lock, 1u);
+            return true;
+        }
+
+        // Called with the queue mutex locked after `count` elements were
+        // pushed, unlocks it. Pushing thread only records how many workers
+        // are missing, threads are created by the cleaning thread outside of
+        // the queue lock. A parked spare worker takes over when a dynamic
+        // worker would be needed and the cleaning thread replaces it.
+        void pushed(std::unique_lock<Mutex> &lock, std::size_t count) {
+            std::size_t hand_offs = 0u;
+            const auto spawn_requested = request_workers(count, hand_offs);
+            lock.unlock();
+
+            if (count == 1u) {
+                this->m_queue_not_empty.notify_one();
+            } else if (count > 1u) {
+                this->m_queue_not_empty.notify_all();
+            }
+
+            for (auto i = 0u; i < hand_offs; ++i) {
+                m_spares_handed_off.notify_one();
+            }
+
+            if (spawn_requested) {
+                this->m_worker_exited.notify_one();
+            }
+        }
+
+        // Requests workers for `count` pushed elements, returns whether
+        // the cleaning thread has to spawn some.
+        bool request_workers(std::size_t count, std::size_t &hand_offs) {
+            auto spawn_requested = false;
+            if (count > 0u && m_spares_timed_out) {
+                m_spares_timed_out = false;
+                spawn_requested = missing_spares() > 0u;
+            }
+            for (auto i = 0u; i < count; ++i) {
+                if (request_core_worker()) {
+                    spawn_requested = true;
+                } else if (hand_off_to_spare()) {
+                    spawn_requested = true;
+                    ++hand_offs;
+                } else {
+                    spawn_requested = request_dynamic_worker() || spawn_requested;
+                }
+            }
+            return spawn_requested;
+        }
+
+        // Called by the cleaning thread with the queue mutex locked, there
+        // might be no worker to move elements of registered lanes.
+        void unstage_lanes_for_workers() {
+            const auto size = this->m_task_queue.size();
+            if (!this->unstage_lanes()) {
+                return;
+            }
+
+            std::size_t hand_offs = 0u;
+            request_workers(this->m_task_queue.size() - size, hand_offs);
+            this->m_queue_not_empty.notify_all();
+            for (auto i = 0u; i < hand_offs; ++i) {
+                m_spares_handed_off.notify_one();
+            }
+        }
+
+        bool request_core_worker() {
+            if (m_core_workers.size() + m_requested_core_workers < m_core_workers_size) {
+                ++m_requested_core_workers;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool queue_too_long() const {
+            return this->m_task_queue.size() >= m_max_queue_length;
+        }
+
+        bool dynamic_worker_allowed() const {
+            return m_dynamic_workers.size() + m_requested_dynamic_workers + m_spare_workers.size()
+                   < m_dynamic_workers_max_size;
+        }
+
+        bool request_dynamic_worker() {
+            if (queue_too_long() && dynamic_worker_allowed()) {
+                ++m_requested_dynamic_workers;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool hand_off_to_spare() {
+            if (queue_too_long() && m_parked_spares > 0u) {
+                --m_parked_spares;
+                ++m_hand_offs;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Missing parked spare workers, as long as the pool isn't full.
+        std::size_t missing_spares() const {
+            if (m_spares_timed_out || m_parked_spares >= m_spare_workers_size) {
+                return 0u;
+            }
+            const auto workers = m_dynamic_workers.size() + m_requested_dynamic_workers + m_spare_workers.size();
+            const auto room = workers < m_dynamic_workers_max_size ? m_dynamic_workers_max_size - workers : 0u;
+            return std::min(m_spare_workers_size - m_parked_spares, room);
+        }
+
+        bool spawn_requested() const {
+            return m_requested_core_workers > 0u || m_requested_dynamic_workers > 0u || missing_spares() > 0u;
+        }
+
+        bool any_worker_stopped() const {
+            return m_dynamic_workers.stopped_count() > 0u
+                   || m_core_workers.stopped_count() > 0u
+                   || m_spare_workers.stopped_count() > 0u;
+        }
+
+        void emplace_core_workers(concurrent::workers_list<worker_type> &workers, std::size_t count) {
+            for (auto i = 0u; i < count; ++i) {
+                auto options = this->template make_worker_options<worker_type>();
+                options.lanes = this;
+                workers.emplace_back(
                         this->m_task_queue,
                         this->m_queue_mutex,
                         this->m_queue_not_empty,
                         this->m_queue_empty,
                         this->m_worker_exited,
-                        this->m_semaphore
+                        this->m_semaphore,
+                        concurrent::optional_timeout_waiting_strategy<Duration>(
+                                m_core_timeout
+                        ),
+                        this->m_instrumentation.make_worker_probe(),
+                        options
                 );
-
-                m_core_workers.back().start();
-
-                return true;
             }
+        }
 
-            return false;
+        void emplace_spare_workers(std::size_t count) {
+            for (auto i = 0u; i < count; ++i) {
+                auto options = this->template make_worker_options<spare_worker_type>();
+                options.lanes = this;
+                m_spare_workers.emplace_back(
+                        this->m_task_queue,
+                        this->m_queue_mutex,
+                        this->m_queue_not_empty,
+                        this->m_queue_empty,
+                        this->m_worker_exited,
+                        this->m_semaphore,
+                        spare_waiting_strategy(this),
+                        this->m_instrumentation.make_worker_probe(),
+                        options
+                );
+            }
+            m_parked_spares += count;
         }
 
-        bool conditionally_increase_dynamic_workers_size() {
-            if (this->m_task_queue.size() >= m_max_queue_length
-                    && m_dynamic_workers.size() < m_dynamic_workers_max_size) {
+        void emplace_dynamic_workers(std::size_t count) {
+            for (auto i = 0u; i < count; ++i) {
+                auto options = this->template make_worker_options<dynamic_worker_type>();
+                options.lanes = this;
                 m_dynamic_workers.emplace_back(
                         this->m_task_queue,
                         this->m_queue_mutex,
@@ -153,21 +481,32 @@ namespace concurrent {
                         this->m_semaphore,
                         concurrent::timeout_waiting_strategy<Duration>(
                                 m_timeout
-                        )
+                        ),
+                        this->m_instrumentation.make_worker_probe(),
+                        options
                 );
-                m_dynamic_workers.back().start();
-                return true;
             }
+        }
 
-            return false;
+        // Only the cleaning thread modifies workers lists, so newly emplaced
+        // workers can be safely started after the queue lock is released.
+        template <class Workers>
+        static void start_last(Workers &workers, std::size_t count) {
+            for (auto it = std::prev(workers.end(), count); it != workers.end(); ++it) {
+                it->start();
+            }
         }
 
         void cleaning_thread() {
+            auto lock = lock_at(this->m_queue_mutex, lock_site::cleaning_thread);
+
             while (true) {
-                std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-                this->m_worker_exited.wait(
+                polling_condition_variable<condition_variable_type>(this->m_worker_exited, *this).wait(
                         lock,
-                        [this] { return m_dynamic_workers.stopped_count() > 0u || m_stop_cleaning; }
+                        [this] {
+                            unstage_lanes_for_workers();
+                            return any_worker_stopped() || spawn_requested() || m_stop_cleaning;
+                        }
                 );
 
                 if (m_stop_cleaning) {
@@ -175,6 +514,33 @@ namespace concurrent {
                 }
 
                 m_dynamic_workers.remove_stopped();
+                m_spare_workers.remove_stopped();
+                const auto removed_core_workers = m_core_workers.remove_stopped();
+
+                // a task might have been pushed while the last core worker
+                // was timing out, so it wouldn't have requested a new one
+                if (removed_core_workers > 0u && !this->m_task_queue.empty()) {
+                    request_core_worker();
+                }
+
+                const auto core_workers_count = m_requested_core_workers;
+                const auto dynamic_workers_count = m_requested_dynamic_workers;
+                m_requested_core_workers = 0u;
+                m_requested_dynamic_workers = 0u;
+
+                emplace_core_workers(m_core_workers, core_workers_count);
+                emplace_dynamic_workers(dynamic_workers_count);
+                // spares are spawned up front and replace the ones which took
+                // over a push or timed out afterwards, parked ones which timed
+                // out are replaced after the next push
+                const auto spare_workers_count = missing_spares();
+                emplace_spare_workers(spare_workers_count);
+
+                lock.unlock();
+                start_last(m_core_workers, core_workers_count);
+                start_last(m_dynamic_workers, dynamic_workers_count);
+                start_last(m_spare_workers, spare_workers_count);
+                lock.lock();
             }
         }
     };
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace concurrent {
+    // Task queue with named sub-queues, one per tenant, served by one pool
+    // of workers. Tenants with pending tasks take turns in deficit round
+    // robin: on its turn a tenant may start up to `weight` tasks, so over
+    // time each of them gets a share of workers proportional to its weight,
+    // no matter how many tasks the others have queued.
+    //
+    // A tenant with `max_running` of its tasks running is skipped until one
+    // of them finishes, which leaves the other workers to the rest of
+    // tenants.
+    template <class Tenant = std::string, class Thread = std::thread>
+    class fair_task_queue {
+    public:
+        using task_type = std::function<void()>;
+        using tenant_type = Tenant;
+        using thread_type = Thread;
+
+        static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+    private:
+        struct tenant_state {
+            std::size_t weight;
+            std::size_t max_running;
+            std::deque<task_type> tasks;
+            // tasks the tenant may still start in its current turn
+            std::size_t deficit{0u};
+            std::size_t running{0u};
+            std::size_t executed{0u};
+            bool active{false};
+
+            tenant_state(std::size_t weight, std::size_t max_running):
+                    weight(weight),
+                    max_running(max_running) {
+
+            }
+
+            bool capped() const noexcept {
+                return running >= max_running;
+            }
+        };
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_runnable;
+        std::condition_variable m_completion;
+        std::map<tenant_type, tenant_state> m_tenants;
+        // tenants with pending tasks, the one in turn at front
+        std::deque<tenant_state *> m_active;
+        std::size_t m_unfinished{0u};
+        bool m_stopped{false};
+        std::vector<thread_type> m_workers;
+
+        bool runnable() const {
+            for (const auto tenant: m_active) {
+                if (!tenant->capped()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void end_turn(tenant_state &tenant) {
+            m_active.pop_front();
+            tenant.deficit = 0u;
+            if (tenant.tasks.empty()) {
+                tenant.active = false;
+            } else {
+                m_active.push_back(&tenant);
+            }
+        }
+
+        // Called with the mutex locked and some tenant runnable.
+        tenant_state &pop(task_type &task) {
+            while (m_active.front()->capped()) {
+                end_turn(*m_active.front());
+            }
+
+            auto &tenant = *m_active.front();
+            if (tenant.deficit == 0u) {
+                tenant.deficit = tenant.weight;
+            }
+            task = std::move(tenant.tasks.front());
+            tenant.tasks.pop_front();
+            ++tenant.running;
+            if (--tenant.deficit == 0u || tenant.tasks.empty()) {
+                end_turn(tenant);
+            }
+            return tenant;
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            task_type task;
+
+            while (true) {
+                m_runnable.wait(lock, [this] { return m_stopped || runnable(); });
+                if (!runnable()) {
+                    break;
+                }
+
+                auto &tenant = pop(task);
+                lock.unlock();
+                task();
+                task = nullptr;
+                lock.lock();
+
+                const auto was_capped = tenant.capped();
+                --tenant.running;
+                ++tenant.executed;
+                if (was_capped && tenant.active) {
+                    m_runnable.notify_one();
+                }
+                if (--m_unfinished == 0u) {
+                    m_completion.notify_all();
+                }
+            }
+        }
+
+    public:
+        explicit fair_task_queue(std::size_t number_of_threads = std::thread::hardware_concurrency()) {
+            m_workers.reserve(number_of_threads);
+            for (auto i = 0u; i < number_of_threads; ++i) {
+                m_workers.emplace_back([this] { run(); });
+            }
+        }
+
+        fair_task_queue(const fair_task_queue &) = delete;
+        fair_task_queue &operator=(const fair_task_queue &) = delete;
+
+        ~fair_task_queue() {
+            wait_for_tasks_completion();
+            {
+                const std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+            }
+            m_runnable.notify_all();
+            for (auto &worker: m_workers) {
+                worker.join();
+            }
+        }
+
+        // Adds a tenant or changes weight and cap of an existing one.
+        // Weight and cap of at least 1 are used.
+        void add_tenant(const tenant_type &tenant, std::size_t weight = 1u, std::size_t max_running = unlimited) {
+            weight = weight > 0u ? weight : 1u;
+            max_running = max_running > 0u ? max_running : 1u;
+            {
+                const std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_tenants.find(tenant);
+                if (it == m_tenants.end()) {
+                    it = m_tenants.emplace(tenant, tenant_state(weight, max_running)).first;
+                }
+                it->second.weight = weight;
+                it->second.max_running = max_running;
+            }
+            m_runnable.notify_all();
+        }
+
+        // Throws std::out_of_range if the tenant wasn't added.
+        void push(const tenant_type &tenant, task_type task) {
+            {
+                const std::lock_guard<std::mutex> lock(m_mutex);
+                auto &target = m_tenants.at(tenant);
+                target.tasks.push_back(std::move(task));
+                ++m_unfinished;
+                if (!target.active) {
+                    target.active = true;
+                    m_active.push_back(&target);
+                }
+                if (target.capped()) {
+                    return;
+                }
+            }
+            m_runnable.notify_one();
+        }
+
+        void wait_for_tasks_completion() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_completion.wait(lock, [this] { return m_unfinished == 0u; });
+        }
+
+        // Pending tasks of all tenants.
+        std::size_t size() const {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            std::size_t result = 0u;
+            for (const auto &tenant: m_tenants) {
+                result += tenant.second.tasks.size();
+            }
+            return result;
+        }
+
+        std::size_t size(const tenant_type &tenant) const {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            return m_tenants.at(tenant).tasks.size();
+        }
+
+        std::size_t running(const tenant_type &tenant) const {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            return m_tenants.at(tenant).running;
+        }
+
+        std::size_t executed(const tenant_type &tenant) const {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            return m_tenants.at(tenant).executed;
+        }
+    };
+
+    template <class Tenant, class Thread>
+    constexpr std::size_t fair_task_queue<Tenant, Thread>::unlimited;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <climits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#else
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#endif
+
+namespace concurrent {
+    // Blocks the thread while `word` equals `expected` until it's woken up
+    // by `futex_wake_*` of the same word. Spurious wake-ups are possible,
+    // so callers check the word again. On Linux it's the futex system call,
+    // elsewhere threads park in a fixed table of condition variables.
+    using futex_word = std::atomic<std::uint32_t>;
+
+#if defined(__linux__)
+    namespace detail {
+        inline long futex(futex_word &word, int operation, std::uint32_t value, const timespec *timeout) noexcept {
+            static_assert(sizeof(futex_word) == sizeof(std::uint32_t), "futex word has to be 32 bits long");
+            return syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), operation, value, timeout, nullptr, 0);
+        }
+    }
+
+    inline void futex_wait(futex_word &word, std::uint32_t expected) noexcept {
+        detail::futex(word, FUTEX_WAIT_PRIVATE, expected, nullptr);
+    }
+
+    // Returns false if the timeout expired.
+    template <class Rep, class Period>
+    bool futex_wait_for(
+            futex_word &word,
+            std::uint32_t expected,
+            const std::chrono::duration<Rep, Period> &timeout
+    ) noexcept {
+        if (timeout <= timeout.zero()) {
+            return false;
+        }
+
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+        timespec relative;
+        relative.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+        relative.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+
+        return detail::futex(word, FUTEX_WAIT_PRIVATE, expected, &relative) == 0 || errno != ETIMEDOUT;
+    }
+
+    inline void futex_wake_one(futex_word &word) noexcept {
+        detail::futex(word, FUTEX_WAKE_PRIVATE, 1u, nullptr);
+    }
+
+    inline void futex_wake_all(futex_word &word) noexcept {
+        detail::futex(word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+    }
+#else
+    namespace detail {
+        struct parking_bucket {
+            std::mutex mutex;
+            std::condition_variable condition_variable;
+        };
+
+        // Words sharing a bucket wake each other spuriously, which is allowed.
+        inline parking_bucket &bucket_of(const futex_word &word) noexcept {
+            static parking_bucket buckets[64];
+            return buckets[std::hash<const void *>()(&word) % 64u];
+        }
+    }
+
+    inline void futex_wait(futex_word &word, std::uint32_t expected) noexcept {
+        auto &bucket = detail::bucket_of(word);
+        std::unique_lock<std::mutex> lock(bucket.mutex);
+        if (word.load() == expected) {
+            bucket.condition_variable.wait(lock);
+        }
+    }
+
+    template <class Rep, class Period>
+    bool futex_wait_for(
+            futex_word &word,
+            std::uint32_t expected,
+            const std::chrono::duration<Rep, Period> &timeout
+    ) noexcept {
+        auto &bucket = detail::bucket_of(word);
+        std::unique_lock<std::mutex> lock(bucket.mutex);
+        if (word.load() != expected) {
+            return true;
+        }
+        return bucket.condition_variable.wait_for(lock, timeout) == std::cv_status::no_timeout;
+    }
+
+    inline void futex_wake_all(futex_word &word) noexcept {
+        auto &bucket = detail::bucket_of(word);
+        {
+            std::lock_guard<std::mutex> lock(bucket.mutex);
+        }
+        bucket.condition_variable.notify_all();
+    }
+
+    inline void futex_wake_one(futex_word &word) noexcept {
+        // other words' waiters may share the bucket, so all of them are woken
+        futex_wake_all(word);
+    }
+#endif
+}
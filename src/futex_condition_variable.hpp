@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include "futex.hpp"
+
+namespace concurrent {
+    // Condition variable working with any lock, built on a futex word
+    // incremented by notifications. Unlike `std::condition_variable_any`
+    // it has no internal mutex, so notifying doesn't serialize with waiters
+    // and costs no system call when nobody waits.
+    //
+    // Waiters are counted until some notification takes them, not until
+    // they wake up, so a burst of notifications wakes a sleeping waiter only
+    // once. Waiters leaving on their own (timeout, spurious wake up) stay
+    // counted and cost one spare wake up of a later notification.
+    class futex_condition_variable {
+        futex_word m_sequence{0u};
+        std::atomic<std::uint32_t> m_waiters{0u};
+
+        template <class Lock, class Wait>
+        void wait_with(Lock &lock, Wait &&wait) {
+            m_waiters.fetch_add(1u);
+            const auto sequence = m_sequence.load();
+            lock.unlock();
+            wait(sequence);
+            lock.lock();
+        }
+
+    public:
+        futex_condition_variable() = default;
+        futex_condition_variable(const futex_condition_variable &) = delete;
+        futex_condition_variable &operator=(const futex_condition_variable &) = delete;
+
+        void notify_one() noexcept {
+            auto waiters = m_waiters.load();
+            while (waiters > 0u && !m_waiters.compare_exchange_weak(waiters, waiters - 1u)) {
+            }
+
+            if (waiters > 0u) {
+                m_sequence.fetch_add(1u);
+                futex_wake_one(m_sequence);
+            }
+        }
+
+        void notify_all() noexcept {
+            if (m_waiters.exchange(0u) > 0u) {
+                m_sequence.fetch_add(1u);
+                futex_wake_all(m_sequence);
+            }
+        }
+
+        template <class Lock>
+        void wait(Lock &lock) {
+            wait_with(lock, [this](std::uint32_t sequence) { futex_wait(m_sequence, sequence); });
+        }
+
+        template <class Lock, class Predicate>
+        void wait(Lock &lock, Predicate predicate) {
+            while (!predicate()) {
+                wait(lock);
+            }
+        }
+
+        template <class Lock, class Clock, class Duration>
+        std::cv_status wait_until(Lock &lock, const std::chrono::time_point<Clock, Duration> &deadline) {
+            const auto timeout = deadline - Clock::now();
+            if (timeout <= timeout.zero()) {
+                return std::cv_status::timeout;
+            }
+
+            wait_with(lock, [this, &timeout](std::uint32_t sequence) {
+                futex_wait_for(m_sequence, sequence, timeout);
+            });
+            return Clock::now() < deadline ? std::cv_status::no_timeout : std::cv_status::timeout;
+        }
+
+        template <class Lock, class Clock, class Duration, class Predicate>
+        bool wait_until(Lock &lock, const std::chrono::time_point<Clock, Duration> &deadline, Predicate predicate) {
+            while (!predicate()) {
+                if (wait_until(lock, deadline) == std::cv_status::timeout) {
+                    return predicate();
+                }
+            }
+            return true;
+        }
+
+        template <class Lock, class Rep, class Period>
+        std::cv_status wait_for(Lock &lock, const std::chrono::duration<Rep, Period> &timeout) {
+            return wait_until(lock, std::chrono::steady_clock::now() + timeout);
+        }
+
+        template <class Lock, class Rep, class Period, class Predicate>
+        bool wait_for(Lock &lock, const std::chrono::duration<Rep, Period> &timeout, Predicate predicate) {
+            return wait_until(lock, std::chrono::steady_clock::now() + timeout, std::move(predicate));
+        }
+    };
+}
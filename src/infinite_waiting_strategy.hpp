@@ -6,10 +6,10 @@
 namespace concurrent {
     class infinite_waiting_strategy {
     public:
-        template < class Predicate >
+        template < class ConditionVariable, class Lock, class Predicate >
         bool operator()(
-                std::condition_variable &condition_variable,
-                std::unique_lock<std::mutex> &lock,
+                ConditionVariable &condition_variable,
+                Lock &lock,
                 Predicate &&predicate
         ) const {
             condition_variable.wait(lock, std::forward<Predicate>(predicate));
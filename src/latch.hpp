@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "cpu_relax.hpp"
+#include "futex.hpp"
+
+namespace concurrent {
+    // Single-use countdown: threads wait until the counter set in the
+    // constructor is counted down to zero. Counting down is a single atomic
+    // operation, which makes a system call only when it reaches zero while
+    // some thread is parked.
+    //
+    // Parked threads are marked by a bit of the counter itself, so counting
+    // down to zero doesn't touch the latch after the decrement, a waiter
+    // may destroy it as soon as it sees zero. The counter has 31 bits.
+    class latch {
+        static constexpr std::uint32_t parked = 1u << 31u;
+        static constexpr std::uint32_t count_mask = parked - 1u;
+
+        futex_word m_count;
+
+        // Marks the counter as having parked threads, returns its value with
+        // the mark, zero if it was already counted down.
+        std::uint32_t park() noexcept {
+            const auto count = m_count.fetch_or(parked, std::memory_order_acquire);
+            return (count & count_mask) == 0u ? 0u : count | parked;
+        }
+
+    public:
+        explicit latch(unsigned count) noexcept:
+                m_count{count} {
+
+        }
+
+        latch(const latch &) = delete;
+        latch &operator=(const latch &) = delete;
+
+        // Counting down below zero is an error. Waking parked threads only
+        // passes the address of the counter to the kernel, which is safe
+        // even if the latch was destroyed meanwhile.
+        void count_down(unsigned n = 1u) noexcept {
+            const auto count = m_count.fetch_sub(n, std::memory_order_acq_rel);
+            if (count == (n | parked)) {
+                futex_wake_all(m_count);
+            }
+        }
+
+        bool try_wait() const noexcept {
+            return (m_count.load(std::memory_order_acquire) & count_mask) == 0u;
+        }
+
+        unsigned count() const noexcept {
+            return m_count.load(std::memory_order_relaxed) & count_mask;
+        }
+
+        void wait() noexcept {
+            for (auto spins = default_spin_limit(); spins > 0u; --spins) {
+                if (try_wait()) {
+                    return;
+                }
+                cpu_relax();
+            }
+
+            for (auto count = park(); count != 0u; count = park()) {
+                futex_wait(m_count, count);
+            }
+        }
+
+        // Returns false if the counter didn't reach zero in time.
+        template<typename _Rep, typename _Period>
+        bool wait_for(const std::chrono::duration<_Rep, _Period> &time) noexcept {
+            const auto deadline = std::chrono::steady_clock::now() + time;
+
+            for (auto count = park(); count != 0u; count = park()) {
+                const auto timeout = deadline - std::chrono::steady_clock::now();
+                if (timeout <= timeout.zero()) {
+                    return false;
+                }
+
+                futex_wait_for(m_count, count, timeout);
+            }
+            return true;
+        }
+
+        void arrive_and_wait(unsigned n = 1u) noexcept {
+            count_down(n);
+            wait();
+        }
+    };
+
+    using countdown_event = latch;
+}
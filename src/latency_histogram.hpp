@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace concurrent {
+    // Log-linear bucketing in the spirit of HdrHistogram: values are grouped
+    // by power of two and every group is split into 8 linear sub-buckets,
+    // so the relative error of reported values is at most 12.5%.
+    struct histogram_buckets {
+        static constexpr unsigned sub_bucket_bits = 3u;
+        static constexpr unsigned sub_buckets = 1u << sub_bucket_bits;
+        static constexpr unsigned value_bits = 42u;
+        static constexpr std::uint64_t max_value = (std::uint64_t(1) << value_bits) - 1u;
+        static constexpr std::size_t count = (value_bits - sub_bucket_bits + 1u) * sub_buckets;
+
+        static std::size_t index_of(std::uint64_t value) noexcept {
+            value = value > max_value ? max_value : value;
+            if (value < 2u * sub_buckets) {
+                return static_cast<std::size_t>(value);
+            }
+
+            const unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(value));
+            const unsigned shift = magnitude - sub_bucket_bits;
+            return shift * sub_buckets + static_cast<std::size_t>(value >> shift);
+        }
+
+        static std::uint64_t highest_value_of(std::size_t index) noexcept {
+            if (index < 2u * sub_buckets) {
+                return index;
+            }
+
+            const auto shift = index / sub_buckets - 1u;
+            const auto sub_bucket = index % sub_buckets + sub_buckets;
+            return ((std::uint64_t(sub_bucket) + 1u) << shift) - 1u;
+        }
+    };
+
+    class histogram_snapshot {
+        std::vector<std::uint64_t> m_counts;
+        std::uint64_t m_total_count{0u};
+        std::uint64_t m_max{0u};
+
+    public:
+        histogram_snapshot():
+                m_counts(histogram_buckets::count, 0u) {
+
+        }
+
+        void add(std::size_t index, std::uint64_t count) {
+            m_counts[index] += count;
+            m_total_count += count;
+        }
+
+        void merge_max(std::uint64_t value) {
+            m_max = std::max(m_max, value);
+        }
+
+        void merge(const histogram_snapshot &other) {
+            for (auto i = 0u; i < m_counts.size(); ++i) {
+                m_counts[i] += other.m_counts[i];
+            }
+            m_total_count += other.m_total_count;
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        std::uint64_t count() const noexcept {
+            return m_total_count;
+        }
+
+        std::uint64_t max() const noexcept {
+            return m_max;
+        }
+
+        // Returns the highest value equivalent to the value at given percentile (0 - 100).
+        std::uint64_t value_at_percentile(double percentile) const {
+            if (m_total_count == 0u) {
+                return 0u;
+            }
+
+            percentile = std::min(std::max(percentile, 0.0), 100.0);
+            const auto wanted = std::max<std::uint64_t>(
+                    1u,
+                    static_cast<std::uint64_t>(percentile / 100.0 * m_total_count + 0.5)
+            );
+
+            std::uint64_t seen = 0u;
+            for (auto i = 0u; i < m_counts.size(); ++i) {
+                seen += m_counts[i];
+                if (seen >= wanted) {
+                    return std::min(histogram_buckets::highest_value_of(i), m_max);
+                }
+            }
+
+            return m_max;
+        }
+    };
+
+    // Histogram with a single writer and any number of concurrent readers.
+    // Recording is a couple of relaxed loads and stores, without read-modify-write.
+    class latency_histogram {
+        std::array<std::atomic<std::uint64_t>, histogram_buckets::count> m_counts;
+        std::atomic<std::uint64_t> m_max;
+
+    public:
+        latency_histogram() noexcept:
+                m_max(0u) {
+            for (auto &count: m_counts) {
+                count.store(0u, std::memory_order_relaxed);
+            }
+        }
+
+        void record(std::uint64_t value) noexcept {
+            auto &count = m_counts[histogram_buckets::index_of(value)];
+            count.store(count.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+
+            if (value > m_max.load(std::memory_order_relaxed)) {
+                m_max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        void add_to(histogram_snapshot &snapshot) const {
+            for (auto i = 0u; i < m_counts.size(); ++i) {
+                const auto count = m_counts[i].load(std::memory_order_relaxed);
+                if (count > 0u) {
+                    snapshot.add(i, count);
+                }
+            }
+            snapshot.merge_max(m_max.load(std::memory_order_relaxed));
+        }
+    };
+}
+
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "cpu_relax.hpp"
+#include "semaphore.hpp"
+
+namespace concurrent {
+    // Semaphore keeping its count in an atomic, acquiring and releasing
+    // available permits doesn't touch the wrapped `Semaphore`, which only
+    // parks threads when permits run out. Negative count is the number of
+    // permits threads wait for. Interface is the same as of `semaphore`,
+    // so it can be used as the semaphore policy of task queues too.
+    template <class Semaphore = semaphore>
+    class lightweight_semaphore {
+        std::atomic<std::int64_t> m_count;
+        Semaphore m_semaphore;
+
+        // Returns permits which are still missing from the wrapped
+        // semaphore, after the count was decreased by `n`.
+        unsigned take(unsigned n) noexcept {
+            const auto old = m_count.fetch_sub(n);
+            if (old >= static_cast<std::int64_t>(n)) {
+                return 0u;
+            }
+            return old > 0 ? n - static_cast<unsigned>(old) : n;
+        }
+
+    public:
+        explicit lightweight_semaphore(unsigned initial_value):
+                m_count{initial_value},
+                m_semaphore(0u) {
+
+        }
+
+        lightweight_semaphore(const lightweight_semaphore &) = delete;
+        lightweight_semaphore &operator=(const lightweight_semaphore &) = delete;
+
+        bool try_acquire(unsigned n = 1u) noexcept {
+            auto count = m_count.load(std::memory_order_relaxed);
+            while (count >= static_cast<std::int64_t>(n)) {
+                if (m_count.compare_exchange_weak(count, count - n, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Acquires as many of up to `n` permits as available without
+        // waiting, returns their number.
+        unsigned try_acquire_up_to(unsigned n) noexcept {
+            auto count = m_count.load(std::memory_order_relaxed);
+            while (count > 0) {
+                const auto taken = static_cast<std::uint64_t>(count) < n ? static_cast<unsigned>(count) : n;
+                if (m_count.compare_exchange_weak(count, count - taken, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return taken;
+                }
+            }
+            return 0u;
+        }
+
+        void acquire(unsigned n) {
+            for (auto spins = default_spin_limit(); spins > 0u; --spins) {
+                if (try_acquire(n)) {
+                    return;
+                }
+                cpu_relax();
+            }
+
+            const auto missing = take(n);
+            if (missing > 0u) {
+                m_semaphore.acquire(missing);
+            }
+        }
+
+        void acquire() {
+            acquire(1u);
+        }
+
+        template<typename Duration>
+        bool try_acquire_for(const Duration &duration, unsigned n) {
+            if (try_acquire(n)) {
+                return true;
+            }
+
+            const auto missing = take(n);
+            if (missing == 0u || m_semaphore.try_acquire_for(duration, missing)) {
+                return true;
+            }
+
+            // gives back permits nobody released yet, the ones released
+            // in the meantime are already on their way to the semaphore
+            // and have to be taken from it
+            unsigned returned = 0u;
+            auto count = m_count.load();
+            while (count < 0) {
+                const auto waiting = static_cast<std::uint64_t>(-count);
+                returned = waiting < missing ? static_cast<unsigned>(waiting) : missing;
+                if (m_count.compare_exchange_weak(count, count + returned)) {
+                    break;
+                }
+                returned = 0u;
+            }
+            if (returned < missing) {
+                m_semaphore.acquire(missing - returned);
+            }
+            release(n - returned);
+            return false;
+        }
+
+        template<typename Duration>
+        bool try_acquire_for(const Duration &duration) {
+            return try_acquire_for(duration, 1u);
+        }
+
+        void release(unsigned n) {
+            if (n == 0u) {
+                return;
+            }
+
+            const auto old = m_count.fetch_add(n);
+            if (old < 0) {
+                const auto waiting = static_cast<std::uint64_t>(-old);
+                m_semaphore.release(waiting < n ? static_cast<unsigned>(waiting) : n);
+            }
+        }
+
+        void release() {
+            release(1u);
+        }
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace concurrent {
+    // Per-worker slots for tasks pushed by workers themselves. A worker
+    // runs the task from its slot right after the task which pushed it,
+    // while data they share is still in its cache. A newer task pushed by
+    // the same worker replaces the one in its slot, which is pushed to the
+    // shared queue. Tasks waiting in a slot longer than `steal_delay`, when
+    // their worker is stuck with a long task, can be stolen by other
+    // workers.
+    //
+    // Apart from binding worker threads, slots are accessed with the queue
+    // mutex locked.
+    template <class Task>
+    class local_task_slots {
+    public:
+        using task_type = Task;
+        using clock_type = std::chrono::steady_clock;
+
+    private:
+        struct slot {
+            typename std::aligned_storage<sizeof(task_type), alignof(task_type)>::type storage;
+            bool occupied;
+            clock_type::time_point since;
+
+            task_type &task() noexcept {
+                return *reinterpret_cast<task_type *>(&storage);
+            }
+        };
+
+        std::vector<slot> m_slots;
+        const std::chrono::microseconds m_steal_delay;
+        std::size_t m_occupied{0u};
+        std::size_t m_searching{0u};
+
+        // slots and the slot index of the calling worker thread
+        static std::pair<const local_task_slots *, std::size_t> &binding() noexcept {
+            static thread_local std::pair<const local_task_slots *, std::size_t> current{nullptr, 0u};
+            return current;
+        }
+
+    public:
+        // Zero `steal_delay` disables the slots.
+        local_task_slots(std::size_t workers_count, std::chrono::microseconds steal_delay):
+                m_slots(steal_delay > std::chrono::microseconds::zero() ? workers_count : 0u),
+                m_steal_delay(steal_delay) {
+
+        }
+
+        local_task_slots(const local_task_slots &) = delete;
+        local_task_slots &operator=(const local_task_slots &) = delete;
+
+        ~local_task_slots() {
+            for (auto &slot: m_slots) {
+                if (slot.occupied) {
+                    slot.task().~task_type();
+                }
+            }
+        }
+
+        bool enabled() const noexcept {
+            return !m_slots.empty();
+        }
+
+        std::chrono::microseconds steal_delay() const noexcept {
+            return m_steal_delay;
+        }
+
+        // Called by the worker thread of given slot when it starts.
+        void bind(std::size_t index) const noexcept {
+            binding() = {this, index};
+        }
+
+        // Index of the calling thread's slot or `size()` if it isn't a
+        // worker using these slots.
+        std::size_t current_index() const noexcept {
+            const auto &current = binding();
+            return current.first == this ? current.second : m_slots.size();
+        }
+
+        std::size_t size() const noexcept {
+            return m_slots.size();
+        }
+
+        bool any() const noexcept {
+            return m_occupied > 0u;
+        }
+
+        // Whether putting a task to the slot displaces another one.
+        bool occupied(std::size_t index) const noexcept {
+            return m_slots[index].occupied;
+        }
+
+        // A task which was in the slot before is passed to `displace`.
+        template <class Displace>
+        void put(std::size_t index, task_type task, Displace &&displace) {
+            auto &target = m_slots[index];
+            if (target.occupied) {
+                task_type displaced(std::move(target.task()));
+                target.task() = std::move(task);
+                target.since = clock_type::now();
+                displace(std::move(displaced));
+                return;
+            }
+
+            new (&target.storage) task_type(std::move(task));
+            target.occupied = true;
+            target.since = clock_type::now();
+            ++m_occupied;
+        }
+
+        // Takes the task from the slot and passes it to `run`.
+        template <class Run>
+        bool take(std::size_t index, Run &&run) {
+            auto &source = m_slots[index];
+            if (!source.occupied) {
+                return false;
+            }
+
+            task_type task(std::move(source.task()));
+            source.task().~task_type();
+            source.occupied = false;
+            --m_occupied;
+            run(task);
+            return true;
+        }
+
+        // Takes the oldest task which waited longer than `steal_delay`.
+        template <class Run>
+        bool steal(Run &&run) {
+            const auto stale = clock_type::now() - m_steal_delay;
+            auto oldest = m_slots.size();
+            for (auto i = 0u; i < m_slots.size(); ++i) {
+                if (m_slots[i].occupied && m_slots[i].since <= stale
+                        && (oldest == m_slots.size() || m_slots[i].since < m_slots[oldest].since)) {
+                    oldest = i;
+                }
+            }
+            return oldest < m_slots.size() && take(oldest, std::forward<Run>(run));
+        }
+
+        // At most one worker watches slots of the others at once.
+        bool searching() const noexcept {
+            return m_searching > 0u;
+        }
+
+        void begin_search() noexcept {
+            ++m_searching;
+        }
+
+        void end_search() noexcept {
+            --m_searching;
+        }
+    };
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "cpu_relax.hpp"
+#include "futex.hpp"
+#include "futex_condition_variable.hpp"
+#include "mutex_policy.hpp"
+
+namespace concurrent {
+    // Queue lock of Mellor-Crummey and Scott. Every waiting thread spins on
+    // its own node, so handing the mutex over touches a single cache line of
+    // the next thread, and the mutex is granted in order of arrival. Waiters
+    // park on a futex of their node after spinning for a while.
+    //
+    // Nodes come from a small pool owned by every thread, so the mutex can
+    // be used through the standard Lockable interface and one thread can
+    // hold several MCS mutexes at once.
+    class mcs_mutex {
+        static constexpr std::uint32_t granted = 0u;
+        static constexpr std::uint32_t spinning = 1u;
+        static constexpr std::uint32_t parked = 2u;
+        // parked waiter is being woken up, its node is still used by the
+        // releasing thread
+        static constexpr std::uint32_t waking = 3u;
+
+        struct node {
+            std::atomic<node *> next{nullptr};
+            futex_word state{granted};
+            bool in_use{false};
+            bool allocated{false};
+        };
+
+        static constexpr std::size_t nodes_per_thread = 8u;
+
+        std::atomic<node *> m_tail{nullptr};
+        node *m_holder{nullptr};
+
+        static node *acquire_node() {
+            static thread_local node nodes[nodes_per_thread];
+
+            for (auto &candidate: nodes) {
+                if (!candidate.in_use) {
+                    candidate.in_use = true;
+                    return &candidate;
+                }
+            }
+
+            // more mutexes held at once than nodes in the pool
+            auto allocated = std::make_unique<node>();
+            allocated->in_use = true;
+            allocated->allocated = true;
+            return allocated.release();
+        }
+
+        static void release_node(node *released) noexcept {
+            if (released->allocated) {
+                delete released;
+            } else {
+                released->in_use = false;
+            }
+        }
+
+        static void wait_for_grant(node &waiting) noexcept {
+            const auto spin_limit = default_spin_limit();
+            for (auto spins = 0u; spins < spin_limit; ++spins) {
+                if (waiting.state.load(std::memory_order_acquire) == granted) {
+                    return;
+                }
+                cpu_relax();
+            }
+
+            auto expected = spinning;
+            if (!waiting.state.compare_exchange_strong(expected, parked, std::memory_order_acquire)) {
+                return;
+            }
+
+            spin_backoff backoff;
+            for (auto state = waiting.state.load(std::memory_order_acquire);
+                 state != granted;
+                 state = waiting.state.load(std::memory_order_acquire)) {
+                if (state == parked) {
+                    futex_wait(waiting.state, parked);
+                } else {
+                    backoff();
+                }
+            }
+        }
+
+    public:
+        mcs_mutex() = default;
+        mcs_mutex(const mcs_mutex &) = delete;
+        mcs_mutex &operator=(const mcs_mutex &) = delete;
+
+        void lock() {
+            auto acquiring = acquire_node();
+            acquiring->next.store(nullptr, std::memory_order_relaxed);
+            acquiring->state.store(spinning, std::memory_order_relaxed);
+
+            const auto predecessor = m_tail.exchange(acquiring, std::memory_order_acq_rel);
+            if (predecessor) {
+                predecessor->next.store(acquiring, std::memory_order_release);
+                wait_for_grant(*acquiring);
+            }
+
+            m_holder = acquiring;
+        }
+
+        bool try_lock() {
+            auto acquiring = acquire_node();
+            acquiring->next.store(nullptr, std::memory_order_relaxed);
+
+            node *expected = nullptr;
+            if (!m_tail.compare_exchange_strong(expected, acquiring, std::memory_order_acquire, std::memory_order_relaxed)) {
+                release_node(acquiring);
+                return false;
+            }
+
+            m_holder = acquiring;
+            return true;
+        }
+
+        void unlock() noexcept {
+            const auto releasing = m_holder;
+            auto successor = releasing->next.load(std::memory_order_acquire);
+
+            if (!successor) {
+                auto expected = releasing;
+                if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                    release_node(releasing);
+                    return;
+                }
+
+                // successor has swapped the tail, but hasn't linked itself yet
+                spin_backoff backoff;
+                while (!(successor = releasing->next.load(std::memory_order_acquire))) {
+                    backoff();
+                }
+            }
+
+            // once granted, the successor may release and reuse its node, so
+            // a parked one is woken up before the mutex is handed over
+            auto expected = spinning;
+            if (!successor->state.compare_exchange_strong(expected, granted, std::memory_order_release)) {
+                successor->state.store(waking, std::memory_order_relaxed);
+                futex_wake_one(successor->state);
+                successor->state.store(granted, std::memory_order_release);
+            }
+            release_node(releasing);
+        }
+    };
+
+    template <>
+    struct condition_variable_for<mcs_mutex> {
+        using type = futex_condition_variable;
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace concurrent {
+    // Bounded lock-free ring for many producers and many consumers
+    // (Dmitry Vyukov's design). Every cell has a sequence number telling
+    // whether it's ready to be written or read at given position, so
+    // producers and consumers only contend on their own position counter.
+    // Capacity is rounded up to a power of two.
+    template <class T>
+    class mpmc_ring {
+        static constexpr std::size_t cache_line_size = 64u;
+
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+            T &value() noexcept {
+                return *reinterpret_cast<T *>(&storage);
+            }
+        };
+
+        const std::size_t m_mask;
+        const std::unique_ptr<cell[]> m_cells;
+        char m_enqueue_padding[cache_line_size];
+        std::atomic<std::size_t> m_enqueue_position{0u};
+        char m_dequeue_padding[cache_line_size - sizeof(std::size_t)];
+        std::atomic<std::size_t> m_dequeue_position{0u};
+        char m_end_padding[cache_line_size - sizeof(std::size_t)];
+
+        static std::size_t round_up(std::size_t capacity) noexcept {
+            std::size_t size = 2u;
+            while (size < capacity) {
+                size *= 2u;
+            }
+            return size;
+        }
+
+    public:
+        using value_type = T;
+
+        explicit mpmc_ring(std::size_t capacity):
+                m_mask(round_up(capacity) - 1u),
+                m_cells(new cell[m_mask + 1u]) {
+            for (auto i = 0u; i <= m_mask; ++i) {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpmc_ring(const mpmc_ring &) = delete;
+        mpmc_ring &operator=(const mpmc_ring &) = delete;
+
+        ~mpmc_ring() {
+            const auto end = m_enqueue_position.load(std::memory_order_relaxed);
+            for (auto position = m_dequeue_position.load(std::memory_order_relaxed); position != end; ++position) {
+                m_cells[position & m_mask].value().~T();
+            }
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_mask + 1u;
+        }
+
+        // Value is moved from only if it was pushed.
+        template <class U>
+        bool try_push(U &&value) {
+            auto position = m_enqueue_position.load(std::memory_order_relaxed);
+            while (true) {
+                auto &target = m_cells[position & m_mask];
+                const auto sequence = target.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+                if (difference == 0) {
+                    if (m_enqueue_position.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+                        new (&target.storage) T(std::forward<U>(value));
+                        target.sequence.store(position + 1u, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    // full, or the consumer of the previous lap hasn't finished
+                    return false;
+                } else {
+                    position = m_enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T &value) {
+            auto position = m_dequeue_position.load(std::memory_order_relaxed);
+            while (true) {
+                auto &source = m_cells[position & m_mask];
+                const auto sequence = source.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1u);
+
+                if (difference == 0) {
+                    if (m_dequeue_position.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+                        value = std::move(source.value());
+                        source.value().~T();
+                        source.sequence.store(position + m_mask + 1u, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    // empty, or the producer of the position hasn't finished
+                    return false;
+                } else {
+                    position = m_dequeue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+}
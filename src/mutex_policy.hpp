@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+namespace concurrent {
+    // Mutex policy of task queues is any Lockable type. Condition variable
+    // used with it is picked by `condition_variable_for`, which can be
+    // specialized for mutexes with their own condition variables.
+    template <class Mutex>
+    struct condition_variable_for {
+        using type = std::condition_variable_any;
+    };
+
+    template <>
+    struct condition_variable_for<std::mutex> {
+        using type = std::condition_variable;
+    };
+
+    template <class Mutex>
+    using condition_variable_for_t = typename condition_variable_for<Mutex>::type;
+
+    // Places in task queues and workers where the queue mutex is locked.
+    enum class lock_site {
+        push,
+        pop,
+        size,
+        wait_for_tasks_completion,
+        cleaning_thread,
+        other
+    };
+
+    constexpr std::size_t lock_sites_count = 6u;
+
+    // Locks the mutex at given site. Mutexes interested in sites, which lock
+    // them, provide more specialized overload.
+    template <class Mutex>
+    std::unique_lock<Mutex> lock_at(Mutex &mutex, lock_site) {
+        return std::unique_lock<Mutex>(mutex);
+    }
+
+    // Returned lock doesn't own the mutex if it was already locked.
+    template <class Mutex>
+    std::unique_lock<Mutex> try_lock_at(Mutex &mutex, lock_site) {
+        return std::unique_lock<Mutex>(mutex, std::try_to_lock);
+    }
+}
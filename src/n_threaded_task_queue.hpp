@@ -3,94 +3,534 @@
 #include <condition_variable>
 #include <future>
 #include <type_traits>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "blocking_section.hpp"
 #include "worker.hpp"
 #include "workers_pool.hpp"
 #include "infinite_waiting_strategy.hpp"
 #include "task_queue_base.hpp"
 #include "semaphore_validator.hpp"
+#include "startup_policy.hpp"
 
 namespace concurrent {
-    template <class Queue, class Thread, class Semaphore = semaphore>
-    class n_threaded_task_queue: public task_queue_base<Queue, Semaphore> {
+    template <
+            class Queue,
+            class Thread,
+            class Semaphore = semaphore,
+            class Instrumentation = no_instrumentation,
+            class Mutex = std::mutex
+    >
+    class n_threaded_task_queue:
+            public task_queue_base<Queue, Semaphore, Instrumentation, Mutex>,
+            private blocking_handler {
+        using base_type = task_queue_base<Queue, Semaphore, Instrumentation, Mutex>;
+
     public:
-        using queue_type = Queue;
-        using pushed_value_type = typename Queue::pushed_value_type;
+        using queue_type = typename base_type::queue_type;
+        using pushed_value_type = typename base_type::pushed_value_type;
+        using staging_lane = typename base_type::staging_lane;
         using thread_type = Thread;
         using worker_type = concurrent::worker<
                 queue_type,
                 concurrent::infinite_waiting_strategy,
                 thread_type,
-                Semaphore
+                Semaphore,
+                Instrumentation,
+                Mutex
         >;
 
     private:
+        static constexpr std::size_t workers_per_starter_thread = 16u;
+
+        // Compensating workers exit when they find out there are more of
+        // them than blocked workers.
+        class compensating_waiting_strategy {
+            n_threaded_task_queue *m_task_queue;
+
+            bool spare() const noexcept {
+                return m_task_queue->m_compensating_count > m_task_queue->m_blocked_count;
+            }
+
+        public:
+            explicit compensating_waiting_strategy(n_threaded_task_queue *task_queue) noexcept:
+                    m_task_queue(task_queue) {
+
+            }
+
+            template < class ConditionVariable, class Lock, class Predicate >
+            bool operator()(
+                    ConditionVariable &condition_variable,
+                    Lock &lock,
+                    Predicate &&predicate
+            ) const {
+                // a spare compensating worker exits even if there are tasks,
+                // which it would otherwise keep running
+                condition_variable.wait(lock, [this, &predicate] {
+                    return spare() || predicate();
+                });
+                if (!spare()) {
+                    return true;
+                }
+                --m_task_queue->m_compensating_count;
+                return false;
+            }
+        };
+
+        using compensating_worker_type = concurrent::worker<
+                queue_type,
+                compensating_waiting_strategy,
+                thread_type,
+                Semaphore,
+                Instrumentation,
+                Mutex
+        >;
+
+        // declared before workers, which use them until they're joined
+        typename worker_type::local_slots_type m_local_slots;
+        // workers running a task, lazily started workers are added only
+        // when there are more queued tasks than idle ones, other workers
+        // don't count themselves
+        std::atomic<std::size_t> m_busy_workers{0u};
         concurrent::workers_vector<worker_type> m_workers;
+        std::size_t m_started_workers;
+        // workers in blocking sections and workers compensating for them,
+        // stopped compensating workers are kept to be started again
+        std::size_t m_blocked_count{0u};
+        std::size_t m_compensating_count{0u};
+        bool m_stopping{false};
+        // held while compensating workers are started or stopped, so their
+        // threads aren't created nor joined with the queue mutex locked
+        std::mutex m_compensating_mutex;
+        concurrent::workers_list<compensating_worker_type> m_compensating_workers;
 
     public:
         explicit n_threaded_task_queue(
                 std::size_t number_of_threads = std::thread::hardware_concurrency(),
-                queue_type queue = queue_type()
+                queue_type queue = queue_type(),
+                startup_policy startup = startup_policy::eager,
+                std::size_t capacity = unbounded_capacity,
+                std::chrono::microseconds local_task_steal_delay = std::chrono::microseconds::zero()
         ):
-            task_queue_base<Queue, Semaphore>(std::move(queue)),
-            m_workers() {
+            base_type(std::move(queue), capacity),
+            m_local_slots(number_of_threads, local_task_steal_delay),
+            m_workers(),
+            m_started_workers(0u) {
             m_workers.reserve(number_of_threads);
 
             for (std::size_t i = 0u; i < number_of_threads; ++i) {
+                auto options = this->template make_worker_options<worker_type>();
+                options.local_slots = m_local_slots.enabled() ? &m_local_slots : nullptr;
+                options.local_index = i;
+                options.blocking = static_cast<blocking_handler *>(this);
+                options.lanes = this;
+                // only lazily started workers are counted
+                options.busy_workers = startup == startup_policy::lazy ? &m_busy_workers : nullptr;
                 m_workers.emplace_back(
                         this->m_task_queue,
                         this->m_queue_mutex,
                         this->m_queue_not_empty,
                         this->m_queue_empty,
                         this->m_worker_exited,
-                        this->m_semaphore
+                        this->m_semaphore,
+                        concurrent::infinite_waiting_strategy(),
+                        this->m_instrumentation.make_worker_probe(),
+                        options
                 );
             }
 
-            m_workers.start();
+            switch (startup) {
+                case startup_policy::eager:
+                    m_workers.start();
+                    m_started_workers = number_of_threads;
+                    break;
+                case startup_policy::parallel:
+                    start_workers_in_parallel();
+                    m_started_workers = number_of_threads;
+                    break;
+                case startup_policy::lazy:
+                    // tasks passed with queue need workers as well
+                    m_started_workers = std::min(number_of_threads, this->m_task_queue.size());
+                    start_workers(0u, m_started_workers);
+                    break;
+            }
         }
 
+        // Blocks while the queue is full.
         void push(const pushed_value_type &element) {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.push(element);
+            decltype(auto) stamped = this->stamp(element);
+            if (push_local(locking(), this->wait_for_room(), stamped) == local_push::not_local) {
+                enqueue(locked(), this->wait_for_room(), this->pushing(stamped));
             }
-            this->m_queue_not_empty.notify_one();
         }
 
         void push(pushed_value_type &&element) override {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.push(std::move(element));
+            decltype(auto) stamped = this->stamp(std::move(element));
+            if (push_local(locking(), this->wait_for_room(), std::move(stamped)) == local_push::not_local) {
+                enqueue(locked(), this->wait_for_room(), this->pushing(std::move(stamped)));
             }
-            this->m_queue_not_empty.notify_one();
         }
 
         template< class... Args >
         void emplace( Args&&... args ) {
-            {
-                std::lock_guard<std::mutex> lock(this->m_queue_mutex);
-                this->m_task_queue.emplace(std::forward<Args>(args)...);
+            // a local slot holds a constructed task, stamped one is
+            // constructed before the queue mutex is locked
+            if (this->stamps_elements || m_local_slots.current_index() != m_local_slots.size()) {
+                push(pushed_value_type(std::forward<Args>(args)...));
+                return;
+            }
+            enqueue(
+                    locked(),
+                    this->wait_for_room(),
+                    [&](queue_type &queue) { queue.emplace(std::forward<Args>(args)...); }
+            );
+        }
+
+        // Never blocks, fails if the queue is full or its mutex is locked.
+        // Element is moved from only if it was pushed.
+        bool try_push(const pushed_value_type &element) {
+            decltype(auto) stamped = this->stamp(element);
+            const auto local = push_local(try_locking(), this->has_room(), stamped);
+            if (local != local_push::not_local) {
+                return local == local_push::pushed;
+            }
+            return enqueue(try_locked(), this->has_room(), this->pushing(stamped));
+        }
+
+        bool try_push(pushed_value_type &&element) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            const auto local = push_local(try_locking(), this->has_room(), std::move(stamped));
+            const auto accepted = local == local_push::not_local
+                    ? enqueue(try_locked(), this->has_room(), this->pushing(std::move(stamped)))
+                    : local == local_push::pushed;
+            if (!accepted) {
+                this->give_back(element, stamped);
+            }
+            return accepted;
+        }
+
+        // Never blocks, if the queue mutex is locked or the queue is full,
+        // the element is staged in producer's own `lane` instead. Fails only
+        // if the lane is full. Staged elements are moved to the queue by the
+        // next push with the lane, which gets the mutex, or by `flush`. If
+        // the lane is registered, workers move them as well, when they look
+        // for their next task. A worker which started waiting just as the
+        // element was staged finds it only after `poll_interval()`, 5 ms.
+        // Staging doesn't allocate, but pushing to the underlying queue,
+        // here or when staged elements are moved, may, e.g. to a deque.
+        bool try_push(staging_lane &lane, pushed_value_type &&element) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            auto lock = try_locked();
+            if (!lock.owns_lock()) {
+                if (!lane.try_push(std::move(stamped))) {
+                    this->give_back(element, stamped);
+                    return false;
+                }
+                this->staged();
+                this->m_queue_not_empty.notify_one();
+                return true;
+            }
+
+            const auto size = this->m_task_queue.size();
+            auto accepted = true;
+            if (this->unstage(lane) && !this->full()) {
+                this->m_task_queue.push(std::move(stamped));
+                this->m_instrumentation.on_enqueue(this->m_task_queue);
+            } else {
+                accepted = lane.try_push(std::move(stamped));
+            }
+            this->pushed(lock, this->m_task_queue.size() - size);
+            if (!accepted) {
+                this->give_back(element, stamped);
+            }
+            return accepted;
+        }
+
+        // Moves elements staged in `lane` to the queue while it has room.
+        void flush(staging_lane &lane) {
+            auto lock = locked();
+            const auto size = this->m_task_queue.size();
+            this->unstage(lane);
+            this->pushed(lock, this->m_task_queue.size() - size);
+        }
+
+        // Fails if the queue is still full after `duration`.
+        template <class Rep, class Period>
+        bool try_push_for(const pushed_value_type &element, const std::chrono::duration<Rep, Period> &duration) {
+            decltype(auto) stamped = this->stamp(element);
+            const auto local = push_local(locking(), this->wait_for_room_for(duration), stamped);
+            if (local != local_push::not_local) {
+                return local == local_push::pushed;
+            }
+            return enqueue(locked(), this->wait_for_room_for(duration), this->pushing(stamped));
+        }
+
+        template <class Rep, class Period>
+        bool try_push_for(pushed_value_type &&element, const std::chrono::duration<Rep, Period> &duration) {
+            decltype(auto) stamped = this->stamp(std::move(element));
+            const auto local = push_local(locking(), this->wait_for_room_for(duration), std::move(stamped));
+            const auto accepted = local == local_push::not_local
+                    ? enqueue(locked(), this->wait_for_room_for(duration), this->pushing(std::move(stamped)))
+                    : local == local_push::pushed;
+            if (!accepted) {
+                this->give_back(element, stamped);
             }
-            this->m_queue_not_empty.notify_one();
+            return accepted;
         }
 
         void wait_for_tasks_completion() {
             static_assert(!is_semaphore_fake<Semaphore>::value, "Cannot wait for finished task with fake semaphore!");
-            std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-            this->m_queue_empty.wait(lock, [this]{ return this->m_task_queue.empty(); });
-            const auto workers_size = this->m_workers.size();
-            this->m_semaphore.acquire(workers_size);
-            
-            //semaphore was acquired - all task were finished, we need to release it now to allow further execution
-            this->m_semaphore.release(workers_size);
+            this->wait_for_idle_workers(
+                    [this] { return workers_count(); },
+                    [this] { return m_local_slots.any(); }
+            );
         }
 
         ~n_threaded_task_queue() {
             this->wait_until_is_empty();
+            {
+                const std::lock_guard<std::mutex> starting(m_compensating_mutex);
+                {
+                    const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                    m_stopping = true;
+                }
+                m_compensating_workers.stop();
+            }
             m_workers.stop();
 
             // wake all workers to be able to join their threads in destructor
             this->m_queue_not_empty.notify_all();
         }
+
+    protected:
+        // Includes compensating workers, their list is read with the queue
+        // mutex locked.
+        std::size_t workers_count() const noexcept {
+            return m_workers.size() + m_compensating_workers.size();
+        }
+
+        // Pushes by calling `operation` on the queue, e.g. to get a handle of
+        // the pushed element. Blocks while the queue is full.
+        template <class Operation>
+        void push_with(Operation &&operation) {
+            enqueue(locked(), this->wait_for_room(), std::forward<Operation>(operation));
+        }
+
+    private:
+        // Called by a worker entering a blocking section, starts a worker
+        // which runs tasks in its place. A stopped compensating worker is
+        // started again, once its thread exits, before a new one is added.
+        // If no worker can be started, the count is restored and the blocked
+        // worker isn't compensated for.
+        void begin_blocking() override {
+            {
+                const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                ++m_blocked_count;
+                if (m_stopping || m_compensating_count >= m_blocked_count) {
+                    return;
+                }
+                ++m_compensating_count;
+            }
+
+            const std::lock_guard<std::mutex> starting(m_compensating_mutex);
+            if (m_stopping) {
+                return;
+            }
+
+            compensating_worker_type *stopped = nullptr;
+            try {
+                {
+                    // the list and the stopped flags are read with the queue
+                    // mutex locked
+                    const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                    for (auto &worker: m_compensating_workers) {
+                        if (!worker.nonblocking_running()) {
+                            stopped = &worker;
+                            break;
+                        }
+                    }
+                    if (stopped == nullptr) {
+                        auto options = this->template make_worker_options<compensating_worker_type>();
+                        options.blocking = static_cast<blocking_handler *>(this);
+                        options.lanes = this;
+                        m_compensating_workers.emplace_back(
+                                this->m_task_queue,
+                                this->m_queue_mutex,
+                                this->m_queue_not_empty,
+                                this->m_queue_empty,
+                                this->m_worker_exited,
+                                this->m_semaphore,
+                                compensating_waiting_strategy(this),
+                                this->m_instrumentation.make_worker_probe(),
+                                options
+                        );
+                        stopped = &m_compensating_workers.back();
+                    }
+                }
+                stopped->join();
+                stopped->start();
+            } catch (...) {
+                if (stopped != nullptr) {
+                    stopped->stop();
+                }
+                const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                --m_compensating_count;
+                throw;
+            }
+        }
+
+        void end_blocking() override {
+            {
+                const auto lock = lock_at(this->m_queue_mutex, lock_site::other);
+                --m_blocked_count;
+                if (m_compensating_count <= m_blocked_count) {
+                    return;
+                }
+            }
+
+            // an idle compensating worker has to notice it isn't needed
+            this->m_queue_not_empty.notify_all();
+        }
+
+        enum class local_push {
+            not_local,
+            pushed,
+            rejected
+        };
+
+        // Tasks pushed by workers go to their local slots, if they're
+        // enabled. Priority queues order their tasks and never use them.
+        // A task displaced from the slot goes to the queue, so `room` is
+        // checked for it like for any pushed task.
+        template <class Locking, class Room, class Element>
+        local_push push_local(Locking &&locking, Room &&room, Element &&element) {
+            using local_task_type = typename worker_type::task_type;
+            return push_local(
+                    std::forward<Locking>(locking),
+                    std::forward<Room>(room),
+                    std::forward<Element>(element),
+                    std::is_same<pushed_value_type, local_task_type>()
+            );
+        }
+
+        template <class Locking, class Room, class Element>
+        local_push push_local(Locking &&, Room &&, Element &&, std::false_type) {
+            return local_push::not_local;
+        }
+
+        template <class Locking, class Room, class Element>
+        local_push push_local(Locking &&locking, Room &&room, Element &&element, std::true_type) {
+            const auto index = m_local_slots.current_index();
+            if (index == m_local_slots.size()) {
+                return local_push::not_local;
+            }
+
+            auto lock = locking();
+            if (!lock.owns_lock() || (m_local_slots.occupied(index) && !room(lock))) {
+                return local_push::rejected;
+            }
+            auto replaced = false;
+            m_local_slots.put(
+                    index,
+                    std::forward<Element>(element),
+                    [this, &replaced](pushed_value_type &&displaced) {
+                        // already stamped when it was put to the slot
+                        this->m_task_queue.push(std::move(displaced));
+                        replaced = true;
+                    }
+            );
+            this->m_instrumentation.on_enqueue(this->m_task_queue);
+            if (replaced) {
+                pushed(lock, 1u);
+            } else if (!m_local_slots.searching()) {
+                // a worker is woken to watch for the task getting stale
+                lock.unlock();
+                this->m_queue_not_empty.notify_one();
+            }
+            return local_push::pushed;
+        }
+
+        std::unique_lock<Mutex> locked() {
+            return lock_at(this->m_queue_mutex, lock_site::push);
+        }
+
+        std::unique_lock<Mutex> try_locked() {
+            return try_lock_at(this->m_queue_mutex, lock_site::push);
+        }
+
+        auto locking() {
+            return [this] { return locked(); };
+        }
+
+        auto try_locking() {
+            return [this] { return try_locked(); };
+        }
+
+        template <class Room, class Operation>
+        bool enqueue(std::unique_lock<Mutex> lock, Room &&room, Operation &&operation) {
+            if (!lock.owns_lock() || !room(lock)) {
+                return false;
+            }
+            operation(this->m_task_queue);
+            this->m_instrumentation.on_enqueue(this->m_task_queue);
+            pushed(lock, 1u);
+            return true;
+        }
+
+        // Called with the queue mutex locked after `count` elements were
+        // pushed, unlocks it.
+        void pushed(std::unique_lock<Mutex> &lock, std::size_t count) {
+            const auto first_to_start = m_started_workers;
+            // otherwise workers weren't started lazily, or all of them are
+            if (m_started_workers < m_workers.size()) {
+                m_started_workers = std::min(m_workers.size(), m_started_workers + missing_workers());
+            }
+            const auto last_to_start = m_started_workers;
+            lock.unlock();
+
+            if (count == 1u) {
+                this->m_queue_not_empty.notify_one();
+            } else if (count > 1u) {
+                this->m_queue_not_empty.notify_all();
+            }
+
+            // each index is claimed by exactly one pushing thread,
+            // so workers can be started outside of the queue lock
+            start_workers(first_to_start, last_to_start);
+        }
+
+        // Queued tasks which no started idle worker is going to take.
+        std::size_t missing_workers() const {
+            const auto busy = std::min(m_started_workers, m_busy_workers.load(std::memory_order_relaxed));
+            const auto idle = m_started_workers - busy;
+            const auto queued = this->m_task_queue.size();
+            return queued > idle ? queued - idle : 0u;
+        }
+
+        void start_workers(std::size_t first, std::size_t last) {
+            for (auto i = first; i < last; ++i) {
+                m_workers[i].start();
+            }
+        }
+
+        void start_workers_in_parallel() {
+            const std::size_t chunk_size = workers_per_starter_thread;
+            const auto workers_size = m_workers.size();
+            std::vector<std::thread> starters;
+
+            for (auto first = chunk_size; first < workers_size; first += chunk_size) {
+                const auto last = std::min(first + chunk_size, workers_size);
+                starters.emplace_back([this, first, last] { start_workers(first, last); });
+            }
+
+            start_workers(0u, std::min(chunk_size, workers_size));
+
+            for (auto &starter: starters) {
+                starter.join();
+            }
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <utility>
+
+namespace concurrent {
+    // Default instrumentation policy of task queues, all hooks are empty
+    // and are optimised away.
+    class no_instrumentation {
+    public:
+        // Queue policy the task queue stores its elements in.
+        template <class Queue>
+        using stored_queue = Queue;
+
+        class worker_probe {
+        public:
+            void on_wait() noexcept {
+            }
+
+            template <class Task>
+            void on_task_begin(const Task &) noexcept {
+            }
+
+            void on_task_end() noexcept {
+            }
+        };
+
+        worker_probe make_worker_probe() noexcept {
+            return worker_probe();
+        }
+
+        // Called on the push path, returns the element which is pushed to
+        // the queue instead, e.g. stamped with the time it's pushed.
+        template <class Element>
+        Element &&stamp(Element &&element) noexcept {
+            return std::forward<Element>(element);
+        }
+
+        template <class Queue>
+        void on_enqueue(const Queue &) noexcept {
+        }
+    };
+}
+
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+
+namespace concurrent {
+    // Behaves like `timeout_waiting_strategy` unless timeout is zero,
+    // in which case it waits infinitely.
+    template < class Duration >
+    class optional_timeout_waiting_strategy {
+        const Duration m_timeout;
+
+    public:
+        explicit optional_timeout_waiting_strategy(
+                Duration timeout = Duration::zero()
+        ) noexcept:
+                m_timeout(std::move(timeout)) {
+
+        }
+
+        template < class ConditionVariable, class Lock, class Predicate >
+        bool operator()(
+                ConditionVariable &condition_variable,
+                Lock &lock,
+                Predicate &&predicate
+        ) const {
+            if (m_timeout == Duration::zero()) {
+                condition_variable.wait(lock, std::forward<Predicate>(predicate));
+                return true;
+            }
+
+            return condition_variable.wait_for(lock, m_timeout, std::forward<Predicate>(predicate));
+        }
+    };
+}
+
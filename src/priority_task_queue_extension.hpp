@@ -4,6 +4,7 @@
 #pragma once
 #include <memory>
 #include <future>
+#include <utility>
 
 namespace concurrent {
     template < class TaskQueue >
@@ -34,6 +35,33 @@ namespace concurrent {
             this->emplace(std::forward<P>(priority), [task]{task->operator()();});
             return result;
         }
+
+        // Require a queue with handles, like `unsafe_indexed_priority_queue`.
+        // The element is stamped before the queue mutex is locked, like
+        // pushed ones.
+        template <class P, class F, class Queue = typename TaskQueue::queue_type>
+        typename Queue::handle_type push_with_handle(std::pair<P, F> pair) {
+            typename Queue::handle_type handle;
+            typename TaskQueue::pushed_value_type element(std::move(pair.first), std::move(pair.second));
+            decltype(auto) stamped = this->stamp(std::move(element));
+            this->push_with([&handle, &stamped](Queue &queue) {
+                handle = queue.push_with_handle(std::move(stamped));
+            });
+            return handle;
+        }
+
+        // Fail if the task was already taken by a worker or erased.
+        template <class Handle, class P>
+        bool update_priority(const Handle &handle, P &&priority) {
+            return this->modify([&handle, &priority](auto &queue) {
+                return queue.update_priority(handle, std::forward<P>(priority));
+            });
+        }
+
+        template <class Handle>
+        bool erase(const Handle &handle) {
+            return this->modify([&handle](auto &queue) { return queue.erase(handle); });
+        }
     };
 }
 
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "mutex_policy.hpp"
+
+namespace concurrent {
+    struct lock_site_statistics {
+        std::uint64_t acquisitions;
+        std::uint64_t contended_acquisitions;
+        std::chrono::nanoseconds wait_time;
+        std::chrono::nanoseconds max_wait_time;
+        std::chrono::nanoseconds hold_time;
+
+        double contended_ratio() const noexcept {
+            return acquisitions == 0u ? 0.0 : static_cast<double>(contended_acquisitions) / acquisitions;
+        }
+    };
+
+    struct lock_profile {
+        std::array<lock_site_statistics, lock_sites_count> sites;
+
+        const lock_site_statistics &operator[](lock_site site) const noexcept {
+            return sites[static_cast<std::size_t>(site)];
+        }
+
+        lock_site_statistics total() const noexcept {
+            lock_site_statistics result{0u, 0u, {}, {}, {}};
+            for (const auto &site: sites) {
+                result.acquisitions += site.acquisitions;
+                result.contended_acquisitions += site.contended_acquisitions;
+                result.wait_time += site.wait_time;
+                result.max_wait_time = std::max(result.max_wait_time, site.max_wait_time);
+                result.hold_time += site.hold_time;
+            }
+            return result;
+        }
+    };
+
+    // Mutex policy recording how long threads waited for the mutex, how
+    // long they held it and how often it was already locked, separately
+    // for every site locking it with `lock_at`. Locks taken without a site,
+    // e.g. by condition variable after waiting, are attributed to the site
+    // which locked the mutex last in the same thread.
+    template <class Mutex = std::mutex>
+    class profiled_mutex {
+        using clock_type = std::chrono::steady_clock;
+
+        // Written only by the thread holding the mutex, read without locking.
+        struct site_counters {
+            std::atomic<std::uint64_t> acquisitions{0u};
+            std::atomic<std::uint64_t> contended_acquisitions{0u};
+            std::atomic<std::uint64_t> wait_ns{0u};
+            std::atomic<std::uint64_t> max_wait_ns{0u};
+            std::atomic<std::uint64_t> hold_ns{0u};
+        };
+
+        Mutex m_mutex;
+        std::array<site_counters, lock_sites_count> m_sites;
+        lock_site m_holder_site{lock_site::other};
+        clock_type::time_point m_acquired;
+
+        static lock_site &last_site() noexcept {
+            static thread_local lock_site site = lock_site::other;
+            return site;
+        }
+
+        static void add(std::atomic<std::uint64_t> &counter, std::uint64_t value) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static std::uint64_t nanoseconds(clock_type::duration duration) noexcept {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+
+        void acquired(lock_site site, clock_type::time_point now) noexcept {
+            add(m_sites[static_cast<std::size_t>(site)].acquisitions, 1u);
+            m_holder_site = site;
+            m_acquired = now;
+        }
+
+    public:
+        profiled_mutex() = default;
+        profiled_mutex(const profiled_mutex &) = delete;
+        profiled_mutex &operator=(const profiled_mutex &) = delete;
+
+        void lock(lock_site site) {
+            last_site() = site;
+
+            if (m_mutex.try_lock()) {
+                acquired(site, clock_type::now());
+                return;
+            }
+
+            const auto begin = clock_type::now();
+            m_mutex.lock();
+            const auto now = clock_type::now();
+            const auto wait_ns = nanoseconds(now - begin);
+
+            auto &counters = m_sites[static_cast<std::size_t>(site)];
+            add(counters.contended_acquisitions, 1u);
+            add(counters.wait_ns, wait_ns);
+            if (wait_ns > counters.max_wait_ns.load(std::memory_order_relaxed)) {
+                counters.max_wait_ns.store(wait_ns, std::memory_order_relaxed);
+            }
+            acquired(site, now);
+        }
+
+        void lock() {
+            lock(last_site());
+        }
+
+        bool try_lock(lock_site site) {
+            last_site() = site;
+            return try_lock();
+        }
+
+        bool try_lock() {
+            if (!m_mutex.try_lock()) {
+                return false;
+            }
+
+            acquired(last_site(), clock_type::now());
+            return true;
+        }
+
+        void unlock() {
+            add(m_sites[static_cast<std::size_t>(m_holder_site)].hold_ns, nanoseconds(clock_type::now() - m_acquired));
+            m_mutex.unlock();
+        }
+
+        lock_profile profile() const noexcept {
+            lock_profile result;
+            for (auto i = 0u; i < lock_sites_count; ++i) {
+                const auto &counters = m_sites[i];
+                result.sites[i] = {
+                        counters.acquisitions.load(std::memory_order_relaxed),
+                        counters.contended_acquisitions.load(std::memory_order_relaxed),
+                        std::chrono::nanoseconds(counters.wait_ns.load(std::memory_order_relaxed)),
+                        std::chrono::nanoseconds(counters.max_wait_ns.load(std::memory_order_relaxed)),
+                        std::chrono::nanoseconds(counters.hold_ns.load(std::memory_order_relaxed))
+                };
+            }
+            return result;
+        }
+    };
+
+    template <class Mutex>
+    std::unique_lock<profiled_mutex<Mutex>> lock_at(profiled_mutex<Mutex> &mutex, lock_site site) {
+        mutex.lock(site);
+        return std::unique_lock<profiled_mutex<Mutex>>(mutex, std::adopt_lock);
+    }
+
+    template <class Mutex>
+    std::unique_lock<profiled_mutex<Mutex>> try_lock_at(profiled_mutex<Mutex> &mutex, lock_site site) {
+        if (mutex.try_lock(site)) {
+            return std::unique_lock<profiled_mutex<Mutex>>(mutex, std::adopt_lock);
+        }
+        return std::unique_lock<profiled_mutex<Mutex>>(mutex, std::defer_lock);
+    }
+}
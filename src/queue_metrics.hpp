@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "latency_histogram.hpp"
+#include "stamped_queue.hpp"
+#include "stamped_task.hpp"
+#include "worker_slots.hpp"
+
+namespace concurrent {
+    struct queue_metrics_snapshot {
+        struct worker_metrics {
+            std::uint64_t dequeued;
+            std::uint64_t executed;
+            std::chrono::nanoseconds idle_time;
+            std::chrono::nanoseconds busy_time;
+        };
+
+        std::uint64_t enqueued{0u};
+        std::uint64_t dequeued{0u};
+        std::uint64_t executed{0u};
+        std::chrono::nanoseconds idle_time{0};
+        std::chrono::nanoseconds busy_time{0};
+        std::size_t queue_depth_high_water_mark{0u};
+        std::vector<worker_metrics> workers;
+
+        // queue wait time of tasks stamped on push, plain `std::function`
+        // tasks and `stamped_task`
+        histogram_snapshot wait_time;
+        histogram_snapshot execution_time;
+    };
+
+    // Instrumentation policy collecting counters and latency histograms.
+    // Pushed tasks are stamped with the time they're pushed, queues of plain
+    // `std::function` tasks store them as `stamped_task` for it.
+    // Every worker writes only to its own cache-line padded slot, enqueue
+    // counters are written under the queue lock, so no counter is ever
+    // contended. `snapshot` doesn't take any lock.
+    class queue_metrics {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        template <class Queue>
+        using stored_queue = stamped_queue_t<Queue>;
+
+    private:
+        static constexpr std::size_t cache_line_size = 64u;
+
+        static void increase(std::atomic<std::uint64_t> &counter, std::uint64_t value) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static std::uint64_t nanoseconds(clock_type::duration duration) noexcept {
+            return static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+            );
+        }
+
+        struct worker_slot {
+            char leading_padding[cache_line_size];
+            std::atomic<std::uint64_t> dequeued{0u};
+            std::atomic<std::uint64_t> executed{0u};
+            std::atomic<std::uint64_t> idle_ns{0u};
+            std::atomic<std::uint64_t> busy_ns{0u};
+            latency_histogram wait_time;
+            latency_histogram execution_time;
+            char trailing_padding[cache_line_size];
+        };
+
+        struct enqueue_counters {
+            char leading_padding[cache_line_size];
+            std::atomic<std::uint64_t> enqueued{0u};
+            std::atomic<std::size_t> queue_depth_high_water_mark{0u};
+            char trailing_padding[cache_line_size];
+        };
+
+        enqueue_counters m_enqueue_counters;
+        worker_slots<worker_slot> m_slots;
+
+    public:
+        class worker_probe {
+            worker_slots<worker_slot> *m_slots;
+            std::size_t m_index;
+            worker_slot *m_slot;
+            clock_type::time_point m_last_transition;
+            // a task taken without waiting starts when the previous one
+            // ended, so the clock is read once between them
+            bool m_waited;
+
+        public:
+            worker_probe() noexcept:
+                    m_slots(nullptr),
+                    m_index(0u),
+                    m_slot(nullptr),
+                    m_last_transition(),
+                    m_waited(true) {
+
+            }
+
+            worker_probe(worker_slots<worker_slot> &slots, std::size_t index) noexcept:
+                    m_slots(&slots),
+                    m_index(index),
+                    m_slot(&slots[index]),
+                    m_last_transition(),
+                    m_waited(true) {
+
+            }
+
+            worker_probe(worker_probe &&other) noexcept:
+                    m_slots(other.m_slots),
+                    m_index(other.m_index),
+                    m_slot(other.m_slot),
+                    m_last_transition(other.m_last_transition),
+                    m_waited(other.m_waited) {
+                other.m_slot = nullptr;
+            }
+
+            worker_probe(const worker_probe &) = delete;
+            worker_probe &operator=(const worker_probe &) = delete;
+
+            ~worker_probe() {
+                if (m_slot) {
+                    m_slots->release(m_index);
+                }
+            }
+
+            void on_wait() noexcept {
+                if (m_last_transition == clock_type::time_point()) {
+                    m_last_transition = clock_type::now();
+                }
+                m_waited = true;
+            }
+
+            template <class Task>
+            void on_task_begin(const Task &task) noexcept {
+                if (!m_slot) {
+                    return;
+                }
+
+                const auto started = m_last_transition != clock_type::time_point();
+                // the task may have been pushed after the previous one ended
+                const auto now = m_waited || !started
+                                 ? clock_type::now()
+                                 : std::max(m_last_transition, task_enqueue_time(task));
+                increase(m_slot->dequeued, 1u);
+                if (started) {
+                    increase(m_slot->idle_ns, nanoseconds(now - m_last_transition));
+                }
+                record_wait_time(task, now);
+                m_last_transition = now;
+                m_waited = false;
+            }
+
+            void on_task_end() noexcept {
+                if (!m_slot) {
+                    return;
+                }
+
+                const auto now = clock_type::now();
+                const auto busy = nanoseconds(now - m_last_transition);
+                increase(m_slot->executed, 1u);
+                increase(m_slot->busy_ns, busy);
+                m_slot->execution_time.record(busy);
+                m_last_transition = now;
+            }
+
+        private:
+            template <class Task>
+            void record_wait_time(const Task &task, clock_type::time_point now) noexcept {
+                const auto enqueue_time = task_enqueue_time(task);
+                if (enqueue_time != clock_type::time_point()) {
+                    m_slot->wait_time.record(nanoseconds(now - enqueue_time));
+                }
+            }
+        };
+
+        // Slots of destroyed workers are reused, so counters of short living
+        // dynamic workers accumulate. When more than `max_workers` workers
+        // are alive at once, the excess ones aren't measured.
+        explicit queue_metrics(std::size_t max_workers = 1024u):
+                m_enqueue_counters(),
+                m_slots(max_workers) {
+
+        }
+
+        queue_metrics(const queue_metrics &) = delete;
+        queue_metrics &operator=(const queue_metrics &) = delete;
+
+        worker_probe make_worker_probe() {
+            const auto index = m_slots.acquire();
+            if (index == m_slots.capacity()) {
+                return worker_probe();
+            }
+
+            return worker_probe(m_slots, index);
+        }
+
+        template <class Element>
+        decltype(auto) stamp(Element &&element) {
+            return stamp_task(std::forward<Element>(element));
+        }
+
+        template <class Queue>
+        void on_enqueue(const Queue &queue) noexcept {
+            increase(m_enqueue_counters.enqueued, 1u);
+
+            const auto depth = queue.size();
+            if (depth > m_enqueue_counters.queue_depth_high_water_mark.load(std::memory_order_relaxed)) {
+                m_enqueue_counters.queue_depth_high_water_mark.store(depth, std::memory_order_relaxed);
+            }
+        }
+
+        queue_metrics_snapshot snapshot() const {
+            queue_metrics_snapshot result;
+            result.enqueued = m_enqueue_counters.enqueued.load(std::memory_order_relaxed);
+            result.queue_depth_high_water_mark =
+                    m_enqueue_counters.queue_depth_high_water_mark.load(std::memory_order_relaxed);
+
+            const auto slots_count = m_slots.size();
+            result.workers.reserve(slots_count);
+
+            for (auto i = 0u; i < slots_count; ++i) {
+                const auto slot = &m_slots[i];
+                const queue_metrics_snapshot::worker_metrics worker{
+                        slot->dequeued.load(std::memory_order_relaxed),
+                        slot->executed.load(std::memory_order_relaxed),
+                        std::chrono::nanoseconds(slot->idle_ns.load(std::memory_order_relaxed)),
+                        std::chrono::nanoseconds(slot->busy_ns.load(std::memory_order_relaxed))
+                };
+
+                result.dequeued += worker.dequeued;
+                result.executed += worker.executed;
+                result.idle_time += worker.idle_time;
+                result.busy_time += worker.busy_time;
+                result.workers.push_back(worker);
+
+                slot->wait_time.add_to(result.wait_time);
+                slot->execution_time.add_to(result.execution_time);
+            }
+
+            return result;
+        }
+    };
+}
+
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "n_threaded_task_queue.hpp"
+
+namespace concurrent {
+    // View of a priority queue through which only elements with priority
+    // at or above `threshold` can be popped.
+    template <class Queue>
+    class priority_threshold_view {
+    public:
+        using poped_value_type = typename Queue::poped_value_type;
+        using pushed_value_type = typename Queue::pushed_value_type;
+        using priority_type = typename std::remove_const<typename pushed_value_type::first_type>::type;
+
+    private:
+        Queue &m_queue;
+        const priority_type m_threshold;
+
+    public:
+        priority_threshold_view(Queue &queue, priority_type threshold):
+            m_queue(queue),
+            m_threshold(std::move(threshold)) {
+
+        }
+
+        bool admits(const priority_type &priority) const {
+            return !(priority < m_threshold);
+        }
+
+        poped_value_type pop() {
+            return m_queue.pop();
+        }
+
+        bool empty() const {
+            return m_queue.empty() || !admits(m_queue.top_priority());
+        }
+
+        std::size_t size() const {
+            return empty() ? 0u : m_queue.size();
+        }
+    };
+
+    // N-threaded priority task queue with `reserved_threads` of its workers
+    // reserved for tasks with priority at or above `threshold`, so they
+    // don't wait until a worker finishes a long low priority task when the
+    // others are busy. The remaining workers run all tasks.
+    //
+    // Reserved workers wait on their own condition variable, which is
+    // notified only when a task they can run is pushed. At least one worker
+    // runs low priority tasks, at most `number_of_threads - 1` are reserved.
+    template <
+            class Queue,
+            class Thread,
+            class Semaphore = semaphore,
+            class Instrumentation = no_instrumentation,
+            class Mutex = std::mutex
+    >
+    class reserved_priority_task_queue: public n_threaded_task_queue<Queue, Thread, Semaphore, Instrumentation, Mutex> {
+        using base_type = n_threaded_task_queue<Queue, Thread, Semaphore, Instrumentation, Mutex>;
+
+    public:
+        using queue_type = typename base_type::queue_type;
+        using pushed_value_type = typename base_type::pushed_value_type;
+        using staging_lane = typename base_type::staging_lane;
+        using view_type = priority_threshold_view<queue_type>;
+        using priority_type = typename view_type::priority_type;
+        using reserved_worker_type = concurrent::worker<
+                view_type,
+                concurrent::infinite_waiting_strategy,
+                Thread,
+                Semaphore,
+                Instrumentation,
+                Mutex
+        >;
+
+    private:
+        view_type m_view;
+        typename base_type::condition_variable_type m_reserved_not_empty;
+        // declared last, so they're joined first
+        concurrent::workers_vector<reserved_worker_type> m_reserved_workers;
+
+        static std::size_t reserved_count(std::size_t number_of_threads, std::size_t reserved_threads) {
+            return number_of_threads > 0u ? std::min(reserved_threads, number_of_threads - 1u) : 0u;
+        }
+
+        void pushed(bool admitted) {
+            if (admitted) {
+                m_reserved_not_empty.notify_one();
+            }
+        }
+
+    public:
+        reserved_priority_task_queue(
+                std::size_t number_of_threads,
+                std::size_t reserved_threads,
+                priority_type threshold,
+                queue_type queue = queue_type(),
+                startup_policy startup = startup_policy::eager,
+                std::size_t capacity = unbounded_capacity
+        ):
+            base_type(
+                    number_of_threads - reserved_count(number_of_threads, reserved_threads),
+                    std::move(queue),
+                    startup,
+                    capacity
+            ),
+            m_view(this->m_task_queue, std::move(threshold)),
+            m_reserved_not_empty(),
+            m_reserved_workers() {
+            const auto reserved = reserved_count(number_of_threads, reserved_threads);
+            m_reserved_workers.reserve(reserved);
+
+            for (std::size_t i = 0u; i < reserved; ++i) {
+                m_reserved_workers.emplace_back(
+                        m_view,
+                        this->m_queue_mutex,
+                        m_reserved_not_empty,
+                        this->m_queue_empty,
+                        this->m_worker_exited,
+                        this->m_semaphore,
+                        concurrent::infinite_waiting_strategy(),
+                        this->m_instrumentation.make_worker_probe(),
+                        this->template make_worker_options<reserved_worker_type>()
+                );
+            }
+            m_reserved_workers.start();
+        }
+
+        ~reserved_priority_task_queue() {
+            this->wait_until_is_empty();
+            m_reserved_workers.stop();
+            m_reserved_not_empty.notify_all();
+        }
+
+        // Pushing and emplacing block while the queue is full.
+        void push(const pushed_value_type &element) {
+            const auto admitted = m_view.admits(element.first);
+            base_type::push(element);
+            pushed(admitted);
+        }
+
+        void push(pushed_value_type &&element) override {
+            const auto admitted = m_view.admits(element.first);
+            base_type::push(std::move(element));
+            pushed(admitted);
+        }
+
+        template <class P, class... Args>
+        void emplace(P &&priority, Args&&... args) {
+            const auto admitted = m_view.admits(priority);
+            base_type::emplace(std::forward<P>(priority), std::forward<Args>(args)...);
+            pushed(admitted);
+        }
+
+        bool try_push(const pushed_value_type &element) {
+            const auto accepted = base_type::try_push(element);
+            pushed(accepted && m_view.admits(element.first));
+            return accepted;
+        }
+
+        bool try_push(pushed_value_type &&element) {
+            const auto admitted = m_view.admits(element.first);
+            const auto accepted = base_type::try_push(std::move(element));
+            pushed(accepted && admitted);
+            return accepted;
+        }
+
+        bool try_push(staging_lane &lane, pushed_value_type &&element) {
+            const auto accepted = base_type::try_push(lane, std::move(element));
+            // staged elements might have been pushed as well
+            m_reserved_not_empty.notify_all();
+            return accepted;
+        }
+
+        void flush(staging_lane &lane) {
+            base_type::flush(lane);
+            m_reserved_not_empty.notify_all();
+        }
+
+        template <class Rep, class Period>
+        bool try_push_for(const pushed_value_type &element, const std::chrono::duration<Rep, Period> &duration) {
+            const auto accepted = base_type::try_push_for(element, duration);
+            pushed(accepted && m_view.admits(element.first));
+            return accepted;
+        }
+
+        template <class Rep, class Period>
+        bool try_push_for(pushed_value_type &&element, const std::chrono::duration<Rep, Period> &duration) {
+            const auto admitted = m_view.admits(element.first);
+            const auto accepted = base_type::try_push_for(std::move(element), duration);
+            pushed(accepted && admitted);
+            return accepted;
+        }
+
+        void wait_for_tasks_completion() {
+            static_assert(!is_semaphore_fake<Semaphore>::value, "Cannot wait for finished task with fake semaphore!");
+            this->wait_for_idle_workers(
+                    [this] { return this->workers_count() + m_reserved_workers.size(); },
+                    [] { return false; }
+            );
+        }
+
+        std::size_t reserved_workers() const noexcept {
+            return m_reserved_workers.size();
+        }
+    };
+}
@@ -2,21 +2,23 @@
 
 #include <mutex>
 #include <condition_variable>
+#include "mutex_policy.hpp"
 
 namespace concurrent {
-    class semaphore {
+    template <class Mutex>
+    class basic_semaphore {
         unsigned m_counter;
-        std::mutex m_mutex;
-        std::condition_variable m_cv;
+        Mutex m_mutex;
+        condition_variable_for_t<Mutex> m_cv;
 
     public:
-        explicit semaphore(unsigned initial_value) noexcept:
+        explicit basic_semaphore(unsigned initial_value) noexcept:
                 m_counter(initial_value) {
 
         }
 
         void acquire(unsigned n) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<Mutex> lock(m_mutex);
             m_cv.wait(lock, [this, n]{return m_counter >= n;});
             m_counter -= n;
         }
@@ -27,7 +29,7 @@ namespace concurrent {
 
         template<typename Duration>
         bool try_acquire_for(const Duration &duration, unsigned n) {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            std::unique_lock<Mutex> lock(m_mutex);
 
             if (m_cv.wait_for(lock, duration, [this, n]{return m_counter >= n;})) {
                 m_counter -= n;
@@ -45,7 +47,7 @@ namespace concurrent {
 
         void release(unsigned n) {
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
+                std::lock_guard<Mutex> lock(m_mutex);
                 m_counter += n;
             }
             m_cv.notify_all();
@@ -53,12 +55,12 @@ namespace concurrent {
 
         void release() {
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
+                std::lock_guard<Mutex> lock(m_mutex);
                 ++m_counter;
             }
             m_cv.notify_one();
         }
     };
-}
-
 
+    using semaphore = basic_semaphore<std::mutex>;
+}
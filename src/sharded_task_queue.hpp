@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "task_queue.hpp"
+
+namespace concurrent {
+    inline std::size_t thread_hash() noexcept {
+        // thread ids are often aligned addresses, so their bits are mixed
+        const auto id = static_cast<std::uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ull) >> 32u);
+    }
+
+    // Lane selectors pick lanes of tasks pushed without a key. Each thread
+    // pushes to its own lane.
+    struct thread_lane_selector {
+        std::size_t operator()(std::size_t lanes) const noexcept {
+            static thread_local const std::size_t lane = thread_hash();
+            return lane % lanes;
+        }
+    };
+
+    // Each thread pushes to lanes one after another, starting with its own.
+    struct round_robin_lane_selector {
+        std::size_t operator()(std::size_t lanes) const noexcept {
+            static thread_local std::size_t next = thread_hash();
+            return next++ % lanes;
+        }
+    };
+
+    // Task queue with a lane per worker. Tasks pushed with the same key go
+    // to the same lane, so they're run by the same worker and data they
+    // share stays in its cache.
+    //
+    // A worker whose lane is empty steals from lanes which have at least
+    // `steal_threshold` tasks queued, it means their workers fall behind.
+    // While any task is unfinished, workers which found nothing to run
+    // also scan all lanes after `steal_delay`, so a task doesn't wait long
+    // behind a long task of its lane's worker. Each scan which finds
+    // nothing doubles the delay of the next one, up to 64 times
+    // `steal_delay`, until the worker runs a task or is woken. When the
+    // queue is idle they
+    // sleep until their lane gets a task, only the first task after that
+    // and tasks pushed to a lane with a backlog wake the worker of the next
+    // lane to help. Lanes are only tried to be locked while stealing.
+    //
+    // Tasks pushed without a key go to a lane picked by `LaneSelector`.
+    // The queue has at least one lane.
+    template <class Thread = std::thread, class LaneSelector = thread_lane_selector>
+    class sharded_task_queue: public task_queue<std::function<void()>> {
+    public:
+        using task_type = std::function<void()>;
+        using pushed_value_type = task_type;
+        using thread_type = Thread;
+        using lane_selector_type = LaneSelector;
+
+    private:
+        static constexpr std::size_t cache_line_size = 64u;
+
+        // Lanes don't share cache lines.
+        struct alignas(cache_line_size) lane {
+            std::mutex mutex;
+            std::condition_variable not_empty;
+            std::deque<task_type> tasks;
+            // set when the worker should look for tasks of other lanes
+            bool help_requested{false};
+            // tasks pushed to the lane and not finished yet, wherever
+            // they're run, so pushing and finishing don't share a counter
+            std::atomic<std::size_t> unfinished{0u};
+
+            // Before C++17 `new` doesn't align beyond the fundamental
+            // alignment, the offset of the aligned array is kept before it.
+            static void *operator new[](std::size_t size) {
+                const auto raw = static_cast<unsigned char *>(::operator new[](size + alignof(lane)));
+                const auto offset = alignof(lane) - reinterpret_cast<std::uintptr_t>(raw) % alignof(lane);
+                const auto aligned = raw + offset;
+                aligned[-1] = static_cast<unsigned char>(offset);
+                return aligned;
+            }
+
+            static void operator delete[](void *pointer) noexcept {
+                const auto aligned = static_cast<unsigned char *>(pointer);
+                ::operator delete[](aligned - aligned[-1]);
+            }
+        };
+
+        const std::size_t m_lanes_size;
+        const std::unique_ptr<lane[]> m_lanes;
+        const std::size_t m_steal_threshold;
+        const std::chrono::microseconds m_steal_delay;
+        const std::chrono::microseconds m_max_steal_delay;
+        lane_selector_type m_lane_selector;
+        std::atomic<std::size_t> m_stolen{0u};
+        std::atomic_bool m_stopped{false};
+        std::mutex m_completion_mutex;
+        // notified when all tasks are finished, and when a lane is emptied
+        // if some thread waits until the queue is empty
+        std::condition_variable m_completion;
+        std::atomic<std::size_t> m_waiting_until_empty{0u};
+        std::vector<thread_type> m_workers;
+
+        // Unfinished tasks of all lanes. Of lanes finishing their last tasks
+        // at once, at least the last one sees the others at zero, so it
+        // notifies about completion.
+        std::size_t unfinished() const noexcept {
+            std::size_t result = 0u;
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                result += m_lanes[i].unfinished.load();
+            }
+            return result;
+        }
+
+        // Called after a lane was emptied, with its mutex unlocked.
+        void lane_emptied() {
+            if (m_waiting_until_empty.load() > 0u) {
+                const std::lock_guard<std::mutex> lock(m_completion_mutex);
+                m_completion.notify_all();
+            }
+        }
+
+        bool pop(lane &from, task_type &task) {
+            std::unique_lock<std::mutex> lock(from.mutex);
+            if (from.tasks.empty()) {
+                return false;
+            }
+            task = std::move(from.tasks.front());
+            from.tasks.pop_front();
+            const auto emptied = from.tasks.empty();
+            lock.unlock();
+
+            if (emptied) {
+                lane_emptied();
+            }
+            return true;
+        }
+
+        // Returns the lane the task was stolen from or null.
+        lane *steal(std::size_t home, std::size_t min_size, task_type &task) {
+            for (auto offset = 1u; offset < m_lanes_size; ++offset) {
+                auto &victim = m_lanes[(home + offset) % m_lanes_size];
+                std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+                if (lock.owns_lock() && !victim.tasks.empty() && victim.tasks.size() >= min_size) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    const auto emptied = victim.tasks.empty();
+                    lock.unlock();
+
+                    m_stolen.fetch_add(1u, std::memory_order_relaxed);
+                    if (emptied) {
+                        lane_emptied();
+                    }
+                    return &victim;
+                }
+            }
+            return nullptr;
+        }
+
+        void execute(lane &from, task_type &task) {
+            task();
+            task = nullptr;
+            if (from.unfinished.fetch_sub(1u) == 1u && unfinished() == 0u) {
+                const std::lock_guard<std::mutex> lock(m_completion_mutex);
+                m_completion.notify_all();
+            }
+        }
+
+        void run(std::size_t home) {
+            auto &own = m_lanes[home];
+            task_type task;
+            auto timed_out = false;
+            auto steal_delay = m_steal_delay;
+
+            while (true) {
+                if (pop(own, task)) {
+                    execute(own, task);
+                    timed_out = false;
+                    steal_delay = m_steal_delay;
+                    continue;
+                }
+                if (const auto victim = steal(home, timed_out ? 1u : m_steal_threshold, task)) {
+                    execute(*victim, task);
+                    timed_out = false;
+                    steal_delay = m_steal_delay;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    continue;
+                }
+                if (m_stopped) {
+                    break;
+                }
+                const auto woken = [this, &own] { return !own.tasks.empty() || own.help_requested || m_stopped; };
+                if (unfinished() == 0u) {
+                    own.not_empty.wait(lock, woken);
+                    timed_out = false;
+                } else {
+                    timed_out = !own.not_empty.wait_for(lock, steal_delay, woken);
+                }
+                // if the scan after a timeout finds nothing, the next is later
+                steal_delay = timed_out
+                        ? std::min(steal_delay * 2, m_max_steal_delay)
+                        : m_steal_delay;
+                own.help_requested = false;
+            }
+        }
+
+        void request_help(std::size_t index) {
+            auto &helper = m_lanes[(index + 1u) % m_lanes_size];
+            {
+                const std::lock_guard<std::mutex> lock(helper.mutex);
+                helper.help_requested = true;
+            }
+            helper.not_empty.notify_one();
+        }
+
+    public:
+        explicit sharded_task_queue(
+                std::size_t number_of_threads = std::thread::hardware_concurrency(),
+                std::size_t steal_threshold = 2u,
+                std::chrono::microseconds steal_delay = std::chrono::microseconds(500),
+                lane_selector_type lane_selector = lane_selector_type()
+        ):
+                m_lanes_size(std::max<std::size_t>(number_of_threads, 1u)),
+                m_lanes(new lane[m_lanes_size]),
+                m_steal_threshold(steal_threshold),
+                m_steal_delay(steal_delay),
+                m_max_steal_delay(steal_delay * 64),
+                m_lane_selector(std::move(lane_selector)) {
+            m_workers.reserve(m_lanes_size);
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                m_workers.emplace_back([this, i] { run(i); });
+            }
+        }
+
+        sharded_task_queue(const sharded_task_queue &) = delete;
+        sharded_task_queue &operator=(const sharded_task_queue &) = delete;
+
+        ~sharded_task_queue() {
+            wait_for_tasks_completion();
+            m_stopped = true;
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                // the mutex orders the flag with worker's check before waiting
+                { const std::lock_guard<std::mutex> lock(m_lanes[i].mutex); }
+                m_lanes[i].not_empty.notify_all();
+            }
+            for (auto &worker: m_workers) {
+                worker.join();
+            }
+        }
+
+        template <class Key>
+        std::size_t lane_for(const Key &key) const {
+            return std::hash<Key>()(key) % m_lanes_size;
+        }
+
+        template <class Key>
+        void push(const Key &key, task_type task) {
+            push_to_lane(lane_for(key), std::move(task));
+        }
+
+        void push(const task_type &task) {
+            push_to_lane(m_lane_selector(m_lanes_size), task);
+        }
+
+        void push(task_type &&task) override {
+            push_to_lane(m_lane_selector(m_lanes_size), std::move(task));
+        }
+
+        // Pushes without a key, so the queue works with `parallel_for_each`.
+        template <class... Args>
+        void emplace(Args&&... args) {
+            push(task_type(std::forward<Args>(args)...));
+        }
+
+        void push_to_lane(std::size_t index, task_type task) {
+            auto &target = m_lanes[index];
+            // whether the queue was idle, other lanes are summed only when
+            // this one was
+            const auto idle = target.unfinished.fetch_add(1u) == 0u && unfinished() == 1u;
+            std::size_t backlog;
+            {
+                const std::lock_guard<std::mutex> lock(target.mutex);
+                target.tasks.push_back(std::move(task));
+                backlog = target.tasks.size();
+            }
+            target.not_empty.notify_one();
+
+            // helper keeps stealing while the backlog lasts, so it's woken
+            // only when the backlog appears
+            if (m_lanes_size > 1u && (idle || backlog == m_steal_threshold + 1u)) {
+                request_help(index);
+            }
+        }
+
+        void wait_for_tasks_completion() {
+            std::unique_lock<std::mutex> lock(m_completion_mutex);
+            m_completion.wait(lock, [this] { return unfinished() == 0u; });
+        }
+
+        // Returns when no task is queued, tasks taken by workers may still
+        // be running.
+        void wait_until_is_empty() override {
+            std::unique_lock<std::mutex> lock(m_completion_mutex);
+            ++m_waiting_until_empty;
+            m_completion.wait(lock, [this] { return empty(); });
+            --m_waiting_until_empty;
+        }
+
+        // Removes queued tasks of all lanes, running tasks are finished.
+        void clear() override {
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                auto &cleared = m_lanes[i];
+                std::unique_lock<std::mutex> lock(cleared.mutex);
+                const auto removed = cleared.tasks.size();
+                cleared.tasks.clear();
+                lock.unlock();
+
+                if (removed > 0u) {
+                    cleared.unfinished.fetch_sub(removed);
+                    lane_emptied();
+                }
+            }
+
+            if (unfinished() == 0u) {
+                const std::lock_guard<std::mutex> lock(m_completion_mutex);
+                m_completion.notify_all();
+            }
+        }
+
+        std::size_t lanes() const noexcept {
+            return m_lanes_size;
+        }
+
+        // Number of tasks which were run by a worker of another lane.
+        std::size_t stolen_tasks() const noexcept {
+            return m_stolen.load(std::memory_order_relaxed);
+        }
+
+        std::size_t size() const override {
+            std::size_t result = 0u;
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                const std::lock_guard<std::mutex> lock(m_lanes[i].mutex);
+                result += m_lanes[i].tasks.size();
+            }
+            return result;
+        }
+
+        bool empty() const override {
+            for (auto i = 0u; i < m_lanes_size; ++i) {
+                const std::lock_guard<std::mutex> lock(m_lanes[i].mutex);
+                if (!m_lanes[i].tasks.empty()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Sharded task queue used as a single FIFO for many producers: tasks
+    // are spread over lanes, so producers rarely contend, and workers take
+    // tasks of other lanes as soon as their own lane is empty. Only tasks
+    // of the same lane keep their order.
+    template <class LaneSelector = round_robin_lane_selector, class Thread = std::thread>
+    class multi_lane_task_queue: public sharded_task_queue<Thread, LaneSelector> {
+    public:
+        explicit multi_lane_task_queue(
+                std::size_t number_of_threads = std::thread::hardware_concurrency(),
+                std::chrono::microseconds steal_delay = std::chrono::microseconds(500)
+        ):
+                sharded_task_queue<Thread, LaneSelector>(number_of_threads, 1u, steal_delay) {
+
+        }
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace concurrent {
+    // Bounded ring for a single producer and a single consumer. Each side
+    // owns its position and caches the last seen position of the other
+    // side, so it reads the shared one only when the ring looks full or
+    // empty. Capacity is rounded up to a power of two.
+    template <class T>
+    class spsc_ring {
+        static constexpr std::size_t cache_line_size = 64u;
+
+        using storage_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+        const std::size_t m_mask;
+        const std::unique_ptr<storage_type[]> m_slots;
+        char m_producer_padding[cache_line_size];
+        std::atomic<std::size_t> m_tail{0u};
+        std::size_t m_cached_head{0u};
+        char m_consumer_padding[cache_line_size - 2u * sizeof(std::size_t)];
+        std::atomic<std::size_t> m_head{0u};
+        std::size_t m_cached_tail{0u};
+        char m_end_padding[cache_line_size - 2u * sizeof(std::size_t)];
+
+        static std::size_t round_up(std::size_t capacity) noexcept {
+            std::size_t size = 2u;
+            while (size < capacity) {
+                size *= 2u;
+            }
+            return size;
+        }
+
+        T &slot(std::size_t position) noexcept {
+            return *reinterpret_cast<T *>(&m_slots[position & m_mask]);
+        }
+
+    public:
+        using value_type = T;
+
+        explicit spsc_ring(std::size_t capacity):
+                m_mask(round_up(capacity) - 1u),
+                m_slots(new storage_type[m_mask + 1u]) {
+
+        }
+
+        spsc_ring(const spsc_ring &) = delete;
+        spsc_ring &operator=(const spsc_ring &) = delete;
+
+        ~spsc_ring() {
+            const auto end = m_tail.load(std::memory_order_relaxed);
+            for (auto position = m_head.load(std::memory_order_relaxed); position != end; ++position) {
+                slot(position).~T();
+            }
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_mask + 1u;
+        }
+
+        // Value is moved from only if it was pushed.
+        template <class U>
+        bool try_push(U &&value) {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cached_head > m_mask) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+                if (tail - m_cached_head > m_mask) {
+                    return false;
+                }
+            }
+
+            new (&m_slots[tail & m_mask]) T(std::forward<U>(value));
+            m_tail.store(tail + 1u, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T &value) {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cached_tail) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cached_tail) {
+                    return false;
+                }
+            }
+
+            auto &source = slot(head);
+            value = std::move(source);
+            source.~T();
+            m_head.store(head + 1u, std::memory_order_release);
+            return true;
+        }
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace concurrent {
+    // Implemented by task queues whose producers stage elements in their
+    // own lanes while the queue mutex is locked. Workers move elements of
+    // registered lanes to the queue, so they aren't stranded there when
+    // their producer stops pushing.
+    //
+    // Lanes are unstaged through a plain function, not a virtual one, as
+    // workers do that until they're joined by the destructor of the queue.
+    class staging_lanes {
+    public:
+        // Called with the queue mutex locked, has to call `staged` if some
+        // elements were left in lanes. Returns whether some were moved.
+        using unstage_function = bool (*)(staging_lanes &);
+
+    private:
+        const unstage_function m_unstage;
+        std::atomic<std::size_t> m_registered{0u};
+        std::atomic_bool m_staged{false};
+
+    public:
+        // Idle workers look at registered lanes this often, in case
+        // an element was staged just before they started waiting.
+        static std::chrono::milliseconds poll_interval() noexcept {
+            return std::chrono::milliseconds(5);
+        }
+
+        bool registered() const noexcept {
+            return m_registered.load(std::memory_order_relaxed) > 0u;
+        }
+
+        // Called with the queue mutex locked, returns whether some elements
+        // were moved to the queue.
+        bool unstage_lanes() {
+            if (!m_staged.load(std::memory_order_relaxed) || !m_staged.exchange(false, std::memory_order_acquire)) {
+                return false;
+            }
+            return m_unstage(*this);
+        }
+
+    protected:
+        explicit staging_lanes(unstage_function unstage) noexcept:
+                m_unstage(unstage) {
+
+        }
+
+        ~staging_lanes() = default;
+
+        void staged() noexcept {
+            m_staged.store(true, std::memory_order_release);
+        }
+
+        void lane_registered() noexcept {
+            m_registered.fetch_add(1u, std::memory_order_relaxed);
+        }
+
+        void lane_unregistered() noexcept {
+            m_registered.fetch_sub(1u, std::memory_order_relaxed);
+        }
+    };
+
+    // Waits on a condition variable like waiting threads of a task queue
+    // do, but while some lanes are registered, at most for the poll
+    // interval at a time, so the predicate is checked at least that often.
+    // Registering a lane wakes up waiting threads to start polling.
+    template <class ConditionVariable>
+    class polling_condition_variable {
+        ConditionVariable &m_condition_variable;
+        const staging_lanes &m_lanes;
+
+    public:
+        polling_condition_variable(ConditionVariable &condition_variable, const staging_lanes &lanes) noexcept:
+                m_condition_variable(condition_variable),
+                m_lanes(lanes) {
+
+        }
+
+        template <class Lock, class Predicate>
+        void wait(Lock &lock, Predicate predicate) {
+            while (!predicate()) {
+                if (m_lanes.registered()) {
+                    m_condition_variable.wait_for(lock, staging_lanes::poll_interval());
+                } else {
+                    m_condition_variable.wait(lock);
+                }
+            }
+        }
+
+        template <class Lock, class Rep, class Period, class Predicate>
+        bool wait_for(Lock &lock, const std::chrono::duration<Rep, Period> &timeout, Predicate predicate) {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (!predicate()) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
+                    return false;
+                }
+                std::chrono::steady_clock::duration remaining = deadline - now;
+                if (m_lanes.registered()) {
+                    remaining = std::min<std::chrono::steady_clock::duration>(remaining, staging_lanes::poll_interval());
+                }
+                m_condition_variable.wait_for(lock, remaining);
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include "stamped_task.hpp"
+#include "unsafe_deadline_queue.hpp"
+#include "unsafe_fifo_queue.hpp"
+#include "unsafe_indexed_priority_queue.hpp"
+#include "unsafe_lifo_queue.hpp"
+#include "unsafe_priority_queue.hpp"
+
+namespace concurrent {
+    // Queue policy which stores plain `std::function` tasks as
+    // `stamped_task`, so the time they're pushed is kept next to them in
+    // the queue. Wrapping the task in another `std::function` instead would
+    // allocate on every push. Policies of other tasks and ones with custom
+    // containers are kept as they are.
+    template <class Queue>
+    struct stamped_queue {
+        using type = Queue;
+    };
+
+    template <>
+    struct stamped_queue<unsafe_fifo_queue<std::function<void()>>> {
+        using type = unsafe_fifo_queue<stamped_task<std::function<void()>>>;
+    };
+
+    template <>
+    struct stamped_queue<unsafe_lifo_queue<std::function<void()>>> {
+        using type = unsafe_lifo_queue<stamped_task<std::function<void()>>>;
+    };
+
+    template <class Priority>
+    struct stamped_queue<unsafe_priority_queue<Priority, std::function<void()>>> {
+        using type = unsafe_priority_queue<Priority, stamped_task<std::function<void()>>>;
+    };
+
+    template <class Priority, class Compare>
+    struct stamped_queue<unsafe_indexed_priority_queue<Priority, std::function<void()>, Compare>> {
+        using type = unsafe_indexed_priority_queue<Priority, stamped_task<std::function<void()>>, Compare>;
+    };
+
+    template <class Clock>
+    struct stamped_queue<unsafe_deadline_queue<std::function<void()>, Clock>> {
+        using type = unsafe_deadline_queue<stamped_task<std::function<void()>>, Clock>;
+    };
+
+    template <class Queue>
+    using stamped_queue_t = typename stamped_queue<Queue>::type;
+}
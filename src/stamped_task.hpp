@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace concurrent {
+    // Callable wrapper remembering when the task was pushed, which lets
+    // instrumentation policies measure how long tasks wait in queue. Queues
+    // stamp it on push and store it by value. Optional label has to be
+    // a string literal or otherwise outlive the task.
+    template <class F>
+    class stamped_task {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+    private:
+        F m_function;
+        clock_type::time_point m_enqueue_time;
+        const char *m_label;
+
+    public:
+        template <
+                class G,
+                class = std::enable_if_t<!std::is_same<std::decay_t<G>, stamped_task>::value>
+        >
+        stamped_task(G &&function):
+                m_function(std::forward<G>(function)),
+                m_enqueue_time(),
+                m_label(nullptr) {
+
+        }
+
+        template <class G>
+        stamped_task(const char *label, G &&function):
+                m_function(std::forward<G>(function)),
+                m_enqueue_time(),
+                m_label(label) {
+
+        }
+
+        void operator()() {
+            m_function();
+        }
+
+        clock_type::time_point enqueue_time() const noexcept {
+            return m_enqueue_time;
+        }
+
+        void set_enqueue_time(clock_type::time_point time) noexcept {
+            m_enqueue_time = time;
+        }
+
+        const char *label() const noexcept {
+            return m_label;
+        }
+    };
+
+    // Stamps elements with the time they're pushed to a queue.
+    // `stamped_task`, also paired with a priority or a deadline, is stamped,
+    // elements of other types are left as they are.
+    template <class Element>
+    struct task_stamp {
+        template <class T>
+        static T &&apply(T &&element, std::chrono::steady_clock::time_point) noexcept {
+            return std::forward<T>(element);
+        }
+    };
+
+    template <class F>
+    struct task_stamp<stamped_task<F>> {
+        static stamped_task<F> apply(stamped_task<F> task, std::chrono::steady_clock::time_point time) {
+            task.set_enqueue_time(time);
+            return task;
+        }
+    };
+
+    template <class P, class F>
+    struct task_stamp<std::pair<P, stamped_task<F>>> {
+        static std::pair<P, stamped_task<F>> apply(
+                std::pair<P, stamped_task<F>> element,
+                std::chrono::steady_clock::time_point time
+        ) {
+            element.second.set_enqueue_time(time);
+            return element;
+        }
+    };
+
+    template <class Element>
+    decltype(auto) stamp_task(Element &&element, std::chrono::steady_clock::time_point time) {
+        return task_stamp<std::decay_t<Element>>::apply(std::forward<Element>(element), time);
+    }
+
+    template <class Element>
+    decltype(auto) stamp_task(Element &&element) {
+        return stamp_task(std::forward<Element>(element), std::chrono::steady_clock::now());
+    }
+
+    template <class F>
+    std::chrono::steady_clock::time_point task_enqueue_time(const stamped_task<F> &task) noexcept {
+        return task.enqueue_time();
+    }
+
+    // Tasks which aren't stamped have no enqueue time, clock's epoch is returned instead.
+    template <class Task>
+    std::chrono::steady_clock::time_point task_enqueue_time(const Task &) noexcept {
+        return std::chrono::steady_clock::time_point();
+    }
+
+    template <class F>
+    const char *task_label(const stamped_task<F> &task) noexcept {
+        return task.label();
+    }
+
+    template <class Task>
+    const char *task_label(const Task &) noexcept {
+        return nullptr;
+    }
+}
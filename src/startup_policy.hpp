@@ -0,0 +1,13 @@
+#pragma once
+
+namespace concurrent {
+    enum class startup_policy {
+        // all workers are started one by one in constructor
+        eager,
+        // all workers are started in constructor by a few starter threads
+        parallel,
+        // workers are started by pushing threads when no started worker is idle
+        lazy
+    };
+}
+
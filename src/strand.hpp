@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace concurrent {
+    // Priority with which tasks are pushed to a task queue, for queues of
+    // plain tasks there is none.
+    struct no_priority {
+    };
+
+    template <class PushedValue>
+    struct priority_of {
+        using type = no_priority;
+    };
+
+    template <class Priority, class Task>
+    struct priority_of<std::pair<Priority, Task>> {
+        using type = typename std::remove_const<Priority>::type;
+    };
+
+    // Runs tasks pushed to it one at a time and in push order on workers
+    // of a shared task queue. A strand occupies a worker only while it has
+    // pending tasks: the first one schedules a drain task, which runs up to
+    // `batch_size` consecutive tasks on the same worker and schedules itself
+    // again if more are pending, so other work isn't starved. Batch size of
+    // at least 1 is used. Priority task queues get drain tasks with the
+    // priority given to the strand. If the drain task can't be pushed
+    // again without blocking, e.g. to a full bounded queue, the worker
+    // runs the next batch as well.
+    //
+    // Pending tasks keep the strand's state alive, so a strand can be
+    // destroyed before its tasks have run.
+    template <class TaskQueue>
+    class strand {
+    public:
+        using task_type = std::function<void()>;
+        using priority_type = typename priority_of<typename TaskQueue::pushed_value_type>::type;
+
+        static constexpr std::size_t default_batch_size = 16u;
+
+    private:
+        struct state {
+            TaskQueue &task_queue;
+            const std::size_t batch_size;
+            const priority_type priority;
+            std::mutex mutex;
+            std::deque<task_type> tasks;
+            bool scheduled;
+
+            state(TaskQueue &task_queue, std::size_t batch_size, priority_type priority):
+                    task_queue(task_queue),
+                    batch_size(batch_size > 0u ? batch_size : 1u),
+                    priority(std::move(priority)),
+                    mutex(),
+                    tasks(),
+                    scheduled(false) {
+
+            }
+        };
+
+        std::shared_ptr<state> m_state;
+
+        using pushed_value_type = typename TaskQueue::pushed_value_type;
+
+        static pushed_value_type drain_task(const std::shared_ptr<state> &strand_state, no_priority) {
+            return [strand_state] { drain(strand_state); };
+        }
+
+        template <class Priority>
+        static pushed_value_type drain_task(const std::shared_ptr<state> &strand_state, const Priority &priority) {
+            return std::make_pair(priority, [strand_state] { drain(strand_state); });
+        }
+
+        // Queues without `try_push` are pushed to.
+        template <class Queue>
+        static auto try_push(Queue &queue, pushed_value_type &&element, int)
+                -> decltype(queue.try_push(std::move(element))) {
+            return queue.try_push(std::move(element));
+        }
+
+        template <class Queue>
+        static bool try_push(Queue &queue, pushed_value_type &&element, long) {
+            queue.push(std::move(element));
+            return true;
+        }
+
+        static void unschedule(const std::shared_ptr<state> &strand_state) {
+            const std::lock_guard<std::mutex> lock(strand_state->mutex);
+            strand_state->scheduled = false;
+        }
+
+        // If the drain task can't be pushed, the strand isn't scheduled
+        // anymore. Pending tasks are kept and the next push schedules them.
+        static void schedule(const std::shared_ptr<state> &strand_state) {
+            try {
+                strand_state->task_queue.push(drain_task(strand_state, strand_state->priority));
+            } catch (...) {
+                unschedule(strand_state);
+                throw;
+            }
+        }
+
+        // Schedules the next batch if any task is pending. A worker never
+        // blocks pushing the drain task, a full bounded queue would wait
+        // for workers which might all be draining strands. Returns whether
+        // the drain task couldn't be pushed, so the worker has to run the
+        // next batch itself.
+        static bool finish_batch(const std::shared_ptr<state> &strand_state) {
+            {
+                const std::lock_guard<std::mutex> lock(strand_state->mutex);
+                if (strand_state->tasks.empty()) {
+                    strand_state->scheduled = false;
+                    return false;
+                }
+            }
+            try {
+                return !try_push(strand_state->task_queue, drain_task(strand_state, strand_state->priority), 0);
+            } catch (...) {
+                unschedule(strand_state);
+                throw;
+            }
+        }
+
+        // Returns whether the batch was full, not cut short by the strand
+        // running out of tasks.
+        static bool run_batch(const std::shared_ptr<state> &strand_state) {
+            for (auto i = 0u; i < strand_state->batch_size; ++i) {
+                task_type task;
+                {
+                    const std::lock_guard<std::mutex> lock(strand_state->mutex);
+                    if (strand_state->tasks.empty()) {
+                        strand_state->scheduled = false;
+                        return false;
+                    }
+                    task = std::move(strand_state->tasks.front());
+                    strand_state->tasks.pop_front();
+                }
+
+                try {
+                    task();
+                } catch (...) {
+                    // the exception leaves the worker, so the next batch
+                    // can't be run on it
+                    if (finish_batch(strand_state)) {
+                        unschedule(strand_state);
+                    }
+                    throw;
+                }
+            }
+            return true;
+        }
+
+        static void drain(const std::shared_ptr<state> &strand_state) {
+            while (run_batch(strand_state) && finish_batch(strand_state)) {
+            }
+        }
+
+    public:
+        explicit strand(
+                TaskQueue &task_queue,
+                std::size_t batch_size = default_batch_size,
+                priority_type priority = priority_type()
+        ):
+                m_state(std::make_shared<state>(task_queue, batch_size, std::move(priority))) {
+
+        }
+
+        strand(const strand &) = delete;
+        strand &operator=(const strand &) = delete;
+
+        // If pushing the drain task to the queue throws, the task stays
+        // pending and is run after the next push.
+        void push(task_type task) {
+            {
+                const std::lock_guard<std::mutex> lock(m_state->mutex);
+                m_state->tasks.push_back(std::move(task));
+                if (m_state->scheduled) {
+                    return;
+                }
+                m_state->scheduled = true;
+            }
+            schedule(m_state);
+        }
+
+        template <
+                class F,
+                typename R = decltype(std::declval<F>()())
+        >
+        std::future<R> push_with_result(F &&function) {
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(function));
+            auto result = task->get_future();
+            push([task]{task->operator()();});
+            return result;
+        }
+    };
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include "barrier.hpp"
+#include "cpu_relax.hpp"
+
+namespace concurrent {
+    // Runs bulk-synchronous computations on workers of a task queue: every
+    // iteration calls the step function for all partitions, the next one
+    // starts when all of them finished. Partitions are split among lanes,
+    // lane 0 is run by the calling thread and every other one by a single
+    // task, which runs all iterations of its partitions, so a partition
+    // stays on the same thread for the whole computation and no queue wait
+    // happens between iterations.
+    //
+    // All lanes wait for each other, so a lane is bound to a task only once
+    // the task runs. Lanes which no task started within the takeover
+    // timeout after the calling thread finished its first iteration are
+    // run by the calling thread, so the computation finishes even with
+    // fewer idle workers than lanes.
+    template <class TaskQueue>
+    class superstep_executor {
+        TaskQueue &m_task_queue;
+        const std::size_t m_lanes;
+        const std::chrono::microseconds m_takeover_timeout;
+
+        template <class Step, class StepCompletion>
+        struct computation {
+            const std::size_t partitions;
+            const std::size_t lanes;
+            const std::size_t iterations;
+            Step step;
+            StepCompletion step_completion;
+            std::size_t iteration{0u};
+            std::atomic<std::size_t> next_lane{1u};
+            std::atomic_bool failed{false};
+            std::exception_ptr error;
+            concurrent::barrier step_done;
+
+            computation(
+                    std::size_t partitions,
+                    std::size_t lanes,
+                    std::size_t iterations,
+                    Step step,
+                    StepCompletion step_completion
+            ):
+                    partitions(partitions),
+                    lanes(lanes),
+                    iterations(iterations),
+                    step(std::move(step)),
+                    step_completion(std::move(step_completion)),
+                    step_done(lanes, [this] { complete_step(); }) {
+
+            }
+
+            // After a step function threw, lanes still wait for each other
+            // in every iteration, but no more steps are run.
+            void run_steps(std::size_t lane, std::size_t i) {
+                if (failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                try {
+                    for (auto partition = lane; partition < partitions; partition += lanes) {
+                        step(partition, i);
+                    }
+                } catch (...) {
+                    if (!failed.exchange(true)) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            // Called by a task, fails if the calling thread took all the
+            // remaining lanes over.
+            bool claim_lane(std::size_t &lane) {
+                lane = next_lane.fetch_add(1u);
+                return lane < lanes;
+            }
+
+            void run_lane(std::size_t lane) {
+                for (auto i = 0u; i < iterations; ++i) {
+                    run_steps(lane, i);
+                    step_done.wait();
+                }
+            }
+
+            // Waking an idle worker takes longer than a short step, so
+            // tasks get some time to claim their lanes.
+            void wait_for_claimed_lanes(std::chrono::microseconds timeout) const {
+                const auto deadline = std::chrono::steady_clock::now() + timeout;
+                spin_backoff backoff;
+                while (next_lane.load() < lanes && std::chrono::steady_clock::now() < deadline) {
+                    backoff();
+                }
+            }
+
+            // Runs lane 0 and, after its first iteration, takes over lanes
+            // no task claimed within the timeout. They arrive at the first
+            // barrier and drop out of it, the calling thread waits once for
+            // all of them.
+            void run_calling_lanes(std::chrono::microseconds takeover_timeout) {
+                run_steps(0u, 0u);
+                wait_for_claimed_lanes(takeover_timeout);
+                const auto taken_over = std::min<std::size_t>(next_lane.exchange(lanes), lanes);
+                for (auto lane = taken_over; lane < lanes; ++lane) {
+                    run_steps(lane, 0u);
+                    step_done.arrive_and_drop();
+                }
+                step_done.wait();
+
+                for (auto i = 1u; i < iterations; ++i) {
+                    run_steps(0u, i);
+                    for (auto lane = taken_over; lane < lanes; ++lane) {
+                        run_steps(lane, i);
+                    }
+                    step_done.wait();
+                }
+            }
+
+            void complete_step() {
+                if (!failed.load(std::memory_order_relaxed)) {
+                    try {
+                        step_completion(iteration);
+                    } catch (...) {
+                        failed = true;
+                        error = std::current_exception();
+                    }
+                }
+                ++iteration;
+            }
+        };
+
+    public:
+        superstep_executor(
+                TaskQueue &task_queue,
+                std::size_t lanes,
+                std::chrono::microseconds takeover_timeout = std::chrono::milliseconds(1)
+        ):
+                m_task_queue(task_queue),
+                m_lanes(lanes > 0u ? lanes : 1u),
+                m_takeover_timeout(takeover_timeout) {
+            static_assert(
+                    std::is_convertible<std::function<void()>, typename TaskQueue::pushed_value_type>::value,
+                    "Task queue has to accept plain functions"
+            );
+        }
+
+        std::size_t lanes() const noexcept {
+            return m_lanes;
+        }
+
+        // Calls `step(partition, iteration)` for every partition in
+        // [0, partitions) in `iterations` iterations, partition p is run by
+        // lane p % lanes. The last thread finishing an iteration calls
+        // `step_completion(iteration)` before the next one starts. The first
+        // exception thrown by any of them stops the computation and is
+        // rethrown.
+        template <class Step, class StepCompletion>
+        void run(std::size_t partitions, std::size_t iterations, Step step, StepCompletion step_completion) {
+            if (partitions == 0u || iterations == 0u) {
+                return;
+            }
+
+            using computation_type = computation<Step, StepCompletion>;
+            const auto lanes = partitions < m_lanes ? partitions : m_lanes;
+            const auto state = std::make_shared<computation_type>(
+                    partitions,
+                    lanes,
+                    iterations,
+                    std::move(step),
+                    std::move(step_completion)
+            );
+
+            for (auto lane = 1u; lane < lanes; ++lane) {
+                m_task_queue.push([state] {
+                    std::size_t lane;
+                    if (state->claim_lane(lane)) {
+                        state->run_lane(lane);
+                    }
+                });
+            }
+            state->run_calling_lanes(m_takeover_timeout);
+
+            // all lanes passed the last barrier, so they won't touch
+            // the error anymore
+            if (state->error) {
+                std::rethrow_exception(state->error);
+            }
+        }
+
+        template <class Step>
+        void run(std::size_t partitions, std::size_t iterations, Step step) {
+            run(partitions, iterations, std::move(step), [](std::size_t) {});
+        }
+    };
+}
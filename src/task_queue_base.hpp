@@ -1,60 +1,314 @@
 #pragma once
 
 #include <mutex>
+#include <algorithm>
 #include <condition_variable>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "task_queue.hpp"
+#include "no_instrumentation.hpp"
+#include "mutex_policy.hpp"
+#include "spsc_ring.hpp"
+#include "staging_lanes.hpp"
 
 namespace concurrent {
+    // Capacity of queues which never block pushing threads.
+    constexpr std::size_t unbounded_capacity = std::numeric_limits<std::size_t>::max();
 
-    template <class Queue, class Semaphore>
-    class task_queue_base: public task_queue<typename Queue::pushed_value_type> {
+    // Elements are stored in `Queue` rebound by the instrumentation, e.g. to
+    // keep the time they're pushed next to them.
+    template <class Queue, class Semaphore, class Instrumentation = no_instrumentation, class Mutex = std::mutex>
+    class task_queue_base:
+            public task_queue<typename Instrumentation::template stored_queue<Queue>::pushed_value_type>,
+            public staging_lanes {
     public:
-        using queue_type = Queue;
-        using pushed_value_type = typename Queue::pushed_value_type;
+        using queue_type = typename Instrumentation::template stored_queue<Queue>;
+        using pushed_value_type = typename queue_type::pushed_value_type;
         using semaphore_type = Semaphore;
+        using instrumentation_type = Instrumentation;
+        using mutex_type = Mutex;
+        using condition_variable_type = condition_variable_for_t<Mutex>;
+        // Preallocated buffer of a single producer, which holds elements
+        // the producer couldn't push without waiting for the queue mutex.
+        using staging_lane = spsc_ring<pushed_value_type>;
 
     protected:
         queue_type m_task_queue;
-        mutable std::mutex m_queue_mutex;
-        std::condition_variable m_queue_not_empty;
-        std::condition_variable m_queue_empty;
-        std::condition_variable m_worker_exited;
+        mutable mutex_type m_queue_mutex;
+        condition_variable_type m_queue_not_empty;
+        condition_variable_type m_queue_empty;
+        condition_variable_type m_worker_exited;
+        condition_variable_type m_queue_not_full;
         semaphore_type m_semaphore;
+        instrumentation_type m_instrumentation;
+        const std::size_t m_capacity;
+        // pushing threads waiting for room, workers notify them only if
+        // there are some
+        std::size_t m_waiting_for_room{0u};
+        std::vector<staging_lane *> m_lanes;
 
         explicit task_queue_base(
-                queue_type queue = queue_type()
+                queue_type queue = queue_type(),
+                std::size_t capacity = unbounded_capacity
         ):
+            staging_lanes(&task_queue_base::unstage_registered_lanes),
             m_task_queue(std::move(queue)),
             m_queue_mutex(),
             m_queue_not_empty(),
             m_queue_empty(),
             m_worker_exited(),
-            m_semaphore(0) {
+            m_queue_not_full(),
+            m_semaphore(0),
+            m_instrumentation(),
+            m_capacity(capacity) {
 
         }
 
         ~task_queue_base() noexcept = default;
 
+        // Options of workers taking elements from the queue, which notify
+        // pushing threads waiting for room.
+        template <class Worker>
+        typename Worker::options_type make_worker_options() {
+            typename Worker::options_type options;
+            options.queue_not_full = &m_queue_not_full;
+            options.waiting_for_room = &m_waiting_for_room;
+            return options;
+        }
+
+        // Have to be called with the queue mutex locked.
+        bool full() const {
+            return m_task_queue.size() >= m_capacity;
+        }
+
+        // Waits until the queue is empty and no worker runs a task. The
+        // mutex isn't held while permits of all `workers_count()` workers are
+        // acquired, so running tasks can still push. A worker which took a
+        // task waits for its permit with the mutex locked, so afterwards it's
+        // only tried to be locked and the queue is checked again, along with
+        // tasks kept outside of it, if `local_tasks_pending()`.
+        template <class WorkersCount, class LocalTasksPending>
+        void wait_for_idle_workers(WorkersCount &&workers_count, LocalTasksPending &&local_tasks_pending) {
+            while (true) {
+                std::size_t count;
+                {
+                    auto lock = lock_at(m_queue_mutex, lock_site::wait_for_tasks_completion);
+                    m_queue_empty.wait(lock, [this]{ return m_task_queue.empty(); });
+                    count = workers_count();
+                }
+                m_semaphore.acquire(count);
+
+                auto lock = try_lock_at(m_queue_mutex, lock_site::wait_for_tasks_completion);
+                const auto idle = lock.owns_lock()
+                                  && m_task_queue.empty()
+                                  && !local_tasks_pending()
+                                  && workers_count() == count;
+                if (lock.owns_lock()) {
+                    lock.unlock();
+                }
+
+                //semaphore was acquired - all task were finished, we need to release it now to allow further execution
+                m_semaphore.release(count);
+                if (idle) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // Whether the instrumentation replaces pushed elements, e.g. stamps
+        // them with the time they're pushed. Such elements can't be
+        // constructed in place.
+        static constexpr bool stamps_elements = !std::is_same<
+                decltype(std::declval<instrumentation_type &>().stamp(std::declval<pushed_value_type>())),
+                pushed_value_type &&
+        >::value;
+
+        // Called before the queue mutex is locked, so the clock isn't read
+        // under it. Without such instrumentation the element itself is
+        // returned.
+        template <class Element>
+        decltype(auto) stamp(Element &&element) {
+            return m_instrumentation.stamp(std::forward<Element>(element));
+        }
+
+        // Operation of `enqueue` pushing an already stamped element.
+        template <class Stamped>
+        static auto pushing(Stamped &&stamped) {
+            return [pointer = &stamped](queue_type &queue) { queue.push(std::forward<Stamped>(*pointer)); };
+        }
+
+        // A stamped element which wasn't pushed is given back to the caller.
+        // It's still the same task and it's stamped again when pushed again.
+        void give_back(pushed_value_type &element, pushed_value_type &stamped) {
+            give_back(element, stamped, std::integral_constant<bool, stamps_elements>());
+        }
+
+        void give_back(pushed_value_type &, pushed_value_type &, std::false_type) noexcept {
+        }
+
+        void give_back(pushed_value_type &element, pushed_value_type &stamped, std::true_type) {
+            element = std::move(stamped);
+        }
+
+        // Called with the queue mutex locked. Moves staged elements, which
+        // were stamped before they were staged, to the queue while it has
+        // room, returns whether the lane was emptied.
+        bool unstage(staging_lane &lane) {
+            pushed_value_type element;
+            while (!full()) {
+                if (!lane.try_pop(element)) {
+                    return true;
+                }
+                m_task_queue.push(std::move(element));
+                m_instrumentation.on_enqueue(m_task_queue);
+            }
+            return false;
+        }
+
+        static bool unstage_registered_lanes(staging_lanes &lanes) {
+            return static_cast<task_queue_base &>(lanes).unstage_registered(std::integral_constant<
+                    bool,
+                    std::is_default_constructible<pushed_value_type>::value
+                    && std::is_move_assignable<pushed_value_type>::value
+            >());
+        }
+
+        // lanes hold only elements which can be default constructed and
+        // assigned, e.g. not ones with const keys
+        bool unstage_registered(std::false_type) {
+            return false;
+        }
+
+        bool unstage_registered(std::true_type) {
+            std::size_t moved = 0u;
+            for (auto lane: m_lanes) {
+                const auto size = m_task_queue.size();
+                const auto emptied = unstage(*lane);
+                moved += m_task_queue.size() - size;
+                if (!emptied) {
+                    this->staged();
+                    break;
+                }
+            }
+            // the worker which moved them runs only one
+            if (moved > 1u) {
+                m_queue_not_empty.notify_all();
+            }
+            return moved > 0u;
+        }
+
+        // Conditions checked by pushing threads with the queue mutex locked,
+        // they tell whether the element can be pushed.
+        auto has_room() {
+            return [this](std::unique_lock<mutex_type> &) { return !full(); };
+        }
+
+        auto wait_for_room() {
+            return [this](std::unique_lock<mutex_type> &lock) {
+                if (full()) {
+                    ++m_waiting_for_room;
+                    m_queue_not_full.wait(lock, [this] { return !full(); });
+                    --m_waiting_for_room;
+                }
+                return true;
+            };
+        }
+
+        template <class Duration>
+        auto wait_for_room_for(const Duration &duration) {
+            return [this, &duration](std::unique_lock<mutex_type> &lock) {
+                if (!full()) {
+                    return true;
+                }
+                ++m_waiting_for_room;
+                const auto room = m_queue_not_full.wait_for(lock, duration, [this] { return !full(); });
+                --m_waiting_for_room;
+                return room;
+            };
+        }
+
+        // Calls `operation` on the queue with the mutex locked and returns
+        // its result. Threads waiting for room or for an empty queue are
+        // woken up, if it removed elements.
+        template <class Operation>
+        auto modify(Operation &&operation) {
+            auto lock = lock_at(m_queue_mutex, lock_site::other);
+            const auto size = m_task_queue.size();
+            auto result = operation(m_task_queue);
+            const auto removed = m_task_queue.size() < size;
+            const auto emptied = m_task_queue.empty();
+            lock.unlock();
+
+            if (removed) {
+                m_queue_not_full.notify_all();
+            }
+            if (removed && emptied) {
+                m_queue_empty.notify_all();
+            }
+            return result;
+        }
+
     public:
         void wait_until_is_empty() {
-            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            auto lock = lock_at(m_queue_mutex, lock_site::wait_for_tasks_completion);
             m_queue_empty.wait(lock, [this]{ return m_task_queue.empty(); });
         }
 
+        // Elements staged in a registered lane are moved to the queue by
+        // workers too, not only by pushes with the lane and `flush`.
+        void register_lane(staging_lane &lane) {
+            {
+                const auto lock = lock_at(m_queue_mutex, lock_site::other);
+                m_lanes.push_back(&lane);
+                this->lane_registered();
+            }
+            // threads waiting without polling start to poll
+            m_queue_not_empty.notify_all();
+            m_worker_exited.notify_all();
+        }
+
+        // Elements left in the lane aren't moved to the queue anymore.
+        void unregister_lane(staging_lane &lane) {
+            const auto lock = lock_at(m_queue_mutex, lock_site::other);
+            const auto it = std::find(m_lanes.begin(), m_lanes.end(), &lane);
+            if (it != m_lanes.end()) {
+                m_lanes.erase(it);
+                this->lane_unregistered();
+            }
+        }
+
         void clear() {
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
-            m_task_queue.clear();
+            {
+                const auto lock = lock_at(m_queue_mutex, lock_site::other);
+                m_task_queue.clear();
+            }
+            m_queue_not_full.notify_all();
         }
 
         std::size_t size() const override {
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            const auto lock = lock_at(m_queue_mutex, lock_site::size);
             return m_task_queue.size();
         }
 
         bool empty() const override {
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            const auto lock = lock_at(m_queue_mutex, lock_site::size);
             return m_task_queue.empty();
         }
+
+        std::size_t capacity() const noexcept {
+            return m_capacity;
+        }
+
+        const instrumentation_type &instrumentation() const noexcept {
+            return m_instrumentation;
+        }
+
+        const mutex_type &queue_mutex() const noexcept {
+            return m_queue_mutex;
+        }
     };
 }
\ No newline at end of file
@@ -2,12 +2,16 @@
 
 #include <functional>
 #include "n_threaded_task_queue.hpp"
+#include "reserved_priority_task_queue.hpp"
 #include "unsafe_fifo_queue.hpp"
 #include "dynamic_task_queue.hpp"
 #include "task_queue_extension.hpp"
 #include "priority_task_queue_extension.hpp"
 #include "unsafe_priority_queue.hpp"
+#include "unsafe_indexed_priority_queue.hpp"
+#include "unsafe_deadline_queue.hpp"
 #include "unsafe_lifo_queue.hpp"
+#include "sharded_task_queue.hpp"
 
 
 namespace concurrent {
@@ -52,4 +56,41 @@ namespace concurrent {
                     std::thread
             >
     >;
+
+    using n_threaded_indexed_priority_task_queue = priority_task_queue_extension<
+            n_threaded_task_queue<
+                    concurrent::unsafe_indexed_priority_queue<int, std::function<void()>>,
+                    std::thread
+            >
+    >;
+
+    using dynamic_indexed_priority_task_queue = priority_task_queue_extension<
+            dynamic_task_queue<
+                    concurrent::unsafe_indexed_priority_queue<int, std::function<void()>>,
+                    std::thread
+            >
+    >;
+
+    using n_threaded_reserved_priority_task_queue = priority_task_queue_extension<
+            reserved_priority_task_queue<
+                    concurrent::unsafe_priority_queue<int, std::function<void()>>,
+                    std::thread
+            >
+    >;
+
+    using n_threaded_deadline_task_queue = priority_task_queue_extension<
+            n_threaded_task_queue<
+                    concurrent::unsafe_deadline_queue<std::function<void()>>,
+                    std::thread
+            >
+    >;
+
+    using dynamic_deadline_task_queue = priority_task_queue_extension<
+            dynamic_task_queue<
+                    concurrent::unsafe_deadline_queue<std::function<void()>>,
+                    std::thread
+            >
+    >;
+
+    using multi_lane_fifo_task_queue = task_queue_extension<multi_lane_task_queue<>>;
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "cpu_relax.hpp"
+#include "futex_condition_variable.hpp"
+#include "mutex_policy.hpp"
+
+namespace concurrent {
+    // Fair spin lock granting the mutex in order of arrival. Waiting
+    // threads spin and then yield, they never park, so it suits short
+    // critical sections with no more threads than processors.
+    class ticket_mutex {
+        std::atomic<std::uint32_t> m_next_ticket{0u};
+        std::atomic<std::uint32_t> m_now_serving{0u};
+
+    public:
+        ticket_mutex() = default;
+        ticket_mutex(const ticket_mutex &) = delete;
+        ticket_mutex &operator=(const ticket_mutex &) = delete;
+
+        void lock() noexcept {
+            const auto ticket = m_next_ticket.fetch_add(1u, std::memory_order_relaxed);
+            spin_backoff backoff;
+            while (m_now_serving.load(std::memory_order_acquire) != ticket) {
+                backoff();
+            }
+        }
+
+        bool try_lock() noexcept {
+            auto ticket = m_now_serving.load(std::memory_order_acquire);
+            return m_next_ticket.compare_exchange_strong(
+                    ticket,
+                    ticket + 1u,
+                    std::memory_order_acquire,
+                    std::memory_order_relaxed
+            );
+        }
+
+        void unlock() noexcept {
+            m_now_serving.store(m_now_serving.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+        }
+    };
+
+    template <>
+    struct condition_variable_for<ticket_mutex> {
+        using type = futex_condition_variable;
+    };
+}
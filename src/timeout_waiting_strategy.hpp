@@ -15,10 +15,10 @@ namespace concurrent {
 
         }
 
-        template < class Predicate >
+        template < class ConditionVariable, class Lock, class Predicate >
         bool operator()(
-                std::condition_variable &condition_variable,
-                std::unique_lock<std::mutex> &lock,
+                ConditionVariable &condition_variable,
+                Lock &lock,
                 Predicate &&predicate
         ) const {
             return condition_variable.wait_for(lock, m_timeout, std::forward<Predicate>(predicate));
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <memory>
+#include <cstdint>
+
+namespace concurrent {
+    // Fixed size ring buffer of `Words` 64-bit words long entries with a single
+    // writer, which overwrites the oldest entries when the ring is full.
+    // Every entry is guarded by a sequence number, so readers never block the
+    // writer and skip entries overwritten while they were being read.
+    template <std::size_t Words>
+    class trace_ring {
+    public:
+        using entry_type = std::array<std::uint64_t, Words>;
+
+    private:
+        struct slot {
+            std::atomic<std::uint64_t> sequence;
+            std::array<std::atomic<std::uint64_t>, Words> words;
+        };
+
+        const std::size_t m_mask;
+        std::unique_ptr<slot[]> m_slots;
+        std::atomic<std::uint64_t> m_written;
+
+        static std::size_t round_up_to_power_of_two(std::size_t value) noexcept {
+            std::size_t result = 1u;
+            while (result < value) {
+                result <<= 1u;
+            }
+            return result;
+        }
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit trace_ring(std::size_t capacity):
+                m_mask(round_up_to_power_of_two(capacity) - 1u),
+                m_slots(new slot[m_mask + 1u]),
+                m_written(0u) {
+            for (auto i = 0u; i <= m_mask; ++i) {
+                m_slots[i].sequence.store(0u, std::memory_order_relaxed);
+                for (auto &word: m_slots[i].words) {
+                    word.store(0u, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void push(const entry_type &entry) noexcept {
+            const auto index = m_written.load(std::memory_order_relaxed);
+            auto &slot = m_slots[index & m_mask];
+
+            slot.sequence.store(0u, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (auto i = 0u; i < Words; ++i) {
+                slot.words[i].store(entry[i], std::memory_order_relaxed);
+            }
+            slot.sequence.store(index + 1u, std::memory_order_release);
+            m_written.store(index + 1u, std::memory_order_release);
+        }
+
+        template <class Function>
+        void for_each(Function &&function) const {
+            const auto written = m_written.load(std::memory_order_acquire);
+            const auto capacity = m_mask + 1u;
+            const auto first = written > capacity ? written - capacity : 0u;
+
+            for (auto index = first; index < written; ++index) {
+                const auto &slot = m_slots[index & m_mask];
+                if (slot.sequence.load(std::memory_order_acquire) != index + 1u) {
+                    continue;
+                }
+
+                entry_type entry;
+                for (auto i = 0u; i < Words; ++i) {
+                    entry[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != index + 1u) {
+                    continue;
+                }
+
+                function(entry);
+            }
+        }
+    };
+}
+
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "barrier.hpp"
+
+namespace concurrent {
+    // Reusable barrier for many threads, arrivals are combined in a tree
+    // of counters with `fan_in` children each, so every counter is touched
+    // by at most `fan_in` threads instead of all of them. Every thread
+    // passes its own participant number from range [0, count). Like
+    // `barrier`, tree barrier for no threads doesn't block.
+    class tree_barrier {
+        static constexpr std::size_t cache_line_size = 64u;
+
+        struct node {
+            std::atomic<std::size_t> remaining;
+            std::size_t expected;
+            // index of the parent node, the root is its own parent
+            std::size_t parent;
+            char padding[cache_line_size - 3u * sizeof(std::size_t)];
+        };
+
+        const std::size_t m_count;
+        const std::size_t m_fan_in;
+        std::unique_ptr<node[]> m_nodes;
+        barrier_phase m_phase;
+        std::function<void()> m_completion;
+
+        static std::size_t nodes_size(std::size_t count, std::size_t fan_in) {
+            std::size_t size = 0u;
+            auto level = count;
+            do {
+                level = (level + fan_in - 1u) / fan_in;
+                size += level;
+            } while (level > 1u);
+            return size;
+        }
+
+        // Nodes are stored level by level starting from leaves, the root
+        // is the last one.
+        void build() {
+            std::size_t first = 0u;
+            auto children = m_count;
+            while (true) {
+                const auto level = (children + m_fan_in - 1u) / m_fan_in;
+                const auto next = first + level;
+
+                for (auto i = 0u; i < level; ++i) {
+                    auto &built = m_nodes[first + i];
+                    built.expected = std::min(m_fan_in, children - i * m_fan_in);
+                    built.remaining.store(built.expected, std::memory_order_relaxed);
+                    built.parent = level > 1u ? next + i / m_fan_in : first + i;
+                }
+
+                if (level <= 1u) {
+                    break;
+                }
+                first = next;
+                children = level;
+            }
+        }
+
+        std::uint32_t arrive(std::size_t participant) {
+            assert(participant < m_count);
+            const auto phase = m_phase.current();
+            auto index = participant / m_fan_in;
+
+            while (true) {
+                auto &arrived = m_nodes[index];
+                if (arrived.remaining.fetch_sub(1u, std::memory_order_acq_rel) != 1u) {
+                    return phase;
+                }
+
+                // the last one arriving at the node resets it, nobody else
+                // touches it until the phase completes
+                arrived.remaining.store(arrived.expected, std::memory_order_relaxed);
+                if (arrived.parent == index) {
+                    break;
+                }
+                index = arrived.parent;
+            }
+
+            if (m_completion) {
+                m_completion();
+            }
+            m_phase.advance();
+            return phase;
+        }
+
+    public:
+        explicit tree_barrier(
+                std::size_t count,
+                std::function<void()> completion = std::function<void()>(),
+                std::size_t fan_in = 4u
+        ):
+                m_count(count),
+                m_fan_in(fan_in < 2u ? 2u : fan_in),
+                m_nodes(count > 0u ? new node[nodes_size(count, m_fan_in)] : nullptr),
+                m_phase(),
+                m_completion(std::move(completion)) {
+            if (count > 0u) {
+                build();
+            }
+        }
+
+        tree_barrier(const tree_barrier &) = delete;
+        tree_barrier &operator=(const tree_barrier &) = delete;
+
+        std::size_t size() const noexcept {
+            return m_count;
+        }
+
+        void wait(std::size_t participant) {
+            if (m_count == 0u) {
+                return;
+            }
+            const auto phase = arrive(participant);
+            m_phase.wait(phase);
+        }
+
+        template<typename _Rep, typename _Period>
+        bool wait_for(std::size_t participant, const std::chrono::duration<_Rep, _Period> &time) {
+            if (m_count == 0u) {
+                return true;
+            }
+            const auto deadline = std::chrono::steady_clock::now() + time;
+            const auto phase = arrive(participant);
+            return m_phase.wait_until(phase, deadline);
+        }
+    };
+}
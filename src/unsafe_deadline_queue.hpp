@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace concurrent {
+    // What happens to an element whose deadline passed before it was popped.
+    enum class missed_deadline_policy {
+        run,
+        drop,
+        divert
+    };
+
+    // Shared by copies of a deadline queue, so they can be read while the
+    // queue is owned by a task queue.
+    struct deadline_counters {
+        // elements popped, dropped or diverted after their deadline
+        std::atomic<std::size_t> missed{0u};
+        // elements dropped or diverted instead of being popped
+        std::atomic<std::size_t> dropped{0u};
+    };
+
+    // Queue ordered by absolute deadlines, the earliest one is popped first.
+    // Elements with equal deadlines are popped in order they were pushed.
+    //
+    // Unless the policy is `run`, elements whose deadline passed are removed
+    // by `remove_expired`, which workers call before they check whether
+    // the queue is empty, so they're never popped. Checking the queue
+    // doesn't change it, so it can't become empty between `empty` and `pop`.
+    // Diverted elements are passed to `divert` with the queue mutex locked,
+    // it mustn't push to the same task queue.
+    template <
+            class T,
+            class Clock = std::chrono::steady_clock,
+            class Container = std::multimap<typename Clock::time_point, T>
+    >
+    class unsafe_deadline_queue {
+    public:
+        using poped_value_type = typename Container::mapped_type;
+        using pushed_value_type = typename Container::value_type;
+        using container_type = Container;
+        using clock_type = Clock;
+        using time_point = typename Clock::time_point;
+        using divert_function = std::function<void(T)>;
+
+    private:
+        container_type m_container;
+        missed_deadline_policy m_policy;
+        std::shared_ptr<deadline_counters> m_counters;
+        divert_function m_divert;
+
+    public:
+        explicit unsafe_deadline_queue(container_type container = container_type()):
+            unsafe_deadline_queue(missed_deadline_policy::run, std::make_shared<deadline_counters>(), nullptr, std::move(container)) {
+
+        }
+
+        explicit unsafe_deadline_queue(
+                missed_deadline_policy policy,
+                std::shared_ptr<deadline_counters> counters = std::make_shared<deadline_counters>(),
+                divert_function divert = nullptr,
+                container_type container = container_type()
+        ):
+            m_container(std::move(container)),
+            m_policy(policy),
+            m_counters(std::move(counters)),
+            m_divert(std::move(divert)) {
+
+        }
+
+        // An element whose deadline passed since expired ones were removed
+        // is popped and counted as missed.
+        poped_value_type pop() {
+            if (m_container.begin()->first < clock_type::now()) {
+                m_counters->missed.fetch_add(1u, std::memory_order_relaxed);
+            }
+
+            T element{std::move(m_container.begin()->second)};
+            m_container.erase(m_container.begin());
+            return element;
+        }
+
+        void push(const pushed_value_type &element) {
+            m_container.insert(element);
+        }
+
+        void push(pushed_value_type &&element) {
+            m_container.insert(std::move(element));
+        }
+
+        template< class... Args >
+        void emplace( Args&&... args ) {
+            m_container.emplace(std::forward<Args>(args)...);
+        }
+
+        // Returns whether some elements were removed.
+        bool remove_expired() {
+            if (m_policy == missed_deadline_policy::run) {
+                return false;
+            }
+
+            const auto now = clock_type::now();
+            auto removed = false;
+            while (!m_container.empty() && m_container.begin()->first < now) {
+                if (m_policy == missed_deadline_policy::divert && m_divert) {
+                    m_divert(std::move(m_container.begin()->second));
+                }
+                m_container.erase(m_container.begin());
+                m_counters->missed.fetch_add(1u, std::memory_order_relaxed);
+                m_counters->dropped.fetch_add(1u, std::memory_order_relaxed);
+                removed = true;
+            }
+            return removed;
+        }
+
+        bool empty() const {
+            return m_container.empty();
+        }
+
+        void clear() {
+            return m_container.clear();
+        }
+
+        std::size_t size() const {
+            return m_container.size();
+        }
+
+        missed_deadline_policy policy() const noexcept {
+            return m_policy;
+        }
+
+        const std::shared_ptr<deadline_counters> &counters() const noexcept {
+            return m_counters;
+        }
+    };
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace concurrent {
+    // Priority queue in a binary heap, which tracks positions of its
+    // elements, so an element can be found by a handle returned when it was
+    // pushed. Its priority can be changed and it can be erased in O(log n).
+    // Elements with greater priority are popped first, ones with equal
+    // priorities in order they were pushed.
+    //
+    // Handles of popped or erased elements become invalid, they're checked
+    // by generation of the slot they point to, so they're never mistaken for
+    // handles of elements pushed later.
+    template <class Priority, class T, class Compare = std::less<Priority>>
+    class unsafe_indexed_priority_queue {
+    public:
+        using poped_value_type = T;
+        using pushed_value_type = std::pair<Priority, T>;
+        using container_type = std::vector<pushed_value_type>;
+
+        class handle_type {
+            friend class unsafe_indexed_priority_queue;
+
+            std::size_t m_slot{std::numeric_limits<std::size_t>::max()};
+            std::size_t m_generation{0u};
+
+            handle_type(std::size_t slot, std::size_t generation):
+                m_slot(slot),
+                m_generation(generation) {
+
+            }
+
+        public:
+            handle_type() = default;
+        };
+
+    private:
+        static constexpr std::size_t no_position = std::numeric_limits<std::size_t>::max();
+
+        struct entry {
+            Priority priority;
+            std::uint64_t sequence;
+            std::size_t slot;
+            T value;
+
+            template <class P, class... Args>
+            entry(P &&priority, std::uint64_t sequence, std::size_t slot, Args&&... args):
+                priority(std::forward<P>(priority)),
+                sequence(sequence),
+                slot(slot),
+                value(std::forward<Args>(args)...) {
+
+            }
+        };
+
+        struct slot {
+            std::size_t position;
+            std::size_t generation;
+        };
+
+        std::vector<entry> m_heap;
+        std::vector<slot> m_slots;
+        std::vector<std::size_t> m_free_slots;
+        std::uint64_t m_sequence{0u};
+        Compare m_compare;
+
+        // Whether the element at `first` is popped before the one at `second`.
+        bool before(std::size_t first, std::size_t second) const {
+            const auto &a = m_heap[first];
+            const auto &b = m_heap[second];
+            if (m_compare(b.priority, a.priority)) {
+                return true;
+            }
+            if (m_compare(a.priority, b.priority)) {
+                return false;
+            }
+            return a.sequence < b.sequence;
+        }
+
+        void swap_entries(std::size_t first, std::size_t second) {
+            std::swap(m_heap[first], m_heap[second]);
+            m_slots[m_heap[first].slot].position = first;
+            m_slots[m_heap[second].slot].position = second;
+        }
+
+        std::size_t sift_up(std::size_t position) {
+            while (position > 0u) {
+                const auto parent = (position - 1u) / 2u;
+                if (!before(position, parent)) {
+                    break;
+                }
+                swap_entries(position, parent);
+                position = parent;
+            }
+            return position;
+        }
+
+        void sift_down(std::size_t position) {
+            while (true) {
+                const auto left = 2u * position + 1u;
+                if (left >= m_heap.size()) {
+                    return;
+                }
+                const auto right = left + 1u;
+                const auto child = right < m_heap.size() && before(right, left) ? right : left;
+                if (!before(child, position)) {
+                    return;
+                }
+                swap_entries(position, child);
+                position = child;
+            }
+        }
+
+        void restore(std::size_t position) {
+            sift_down(sift_up(position));
+        }
+
+        std::size_t acquire_slot() {
+            if (m_free_slots.empty()) {
+                m_slots.push_back({no_position, 0u});
+                return m_slots.size() - 1u;
+            }
+            const auto index = m_free_slots.back();
+            m_free_slots.pop_back();
+            return index;
+        }
+
+        void release_slot(std::size_t index) {
+            m_slots[index].position = no_position;
+            ++m_slots[index].generation;
+            m_free_slots.push_back(index);
+        }
+
+        template <class P, class... Args>
+        handle_type insert(P &&priority, Args&&... args) {
+            const auto index = acquire_slot();
+            m_heap.emplace_back(std::forward<P>(priority), m_sequence++, index, std::forward<Args>(args)...);
+            m_slots[index].position = m_heap.size() - 1u;
+            sift_up(m_heap.size() - 1u);
+            return {index, m_slots[index].generation};
+        }
+
+        void remove_at(std::size_t position) {
+            release_slot(m_heap[position].slot);
+            const auto last = m_heap.size() - 1u;
+            if (position != last) {
+                m_heap[position] = std::move(m_heap[last]);
+                m_slots[m_heap[position].slot].position = position;
+            }
+            m_heap.pop_back();
+            if (position < m_heap.size()) {
+                restore(position);
+            }
+        }
+
+    public:
+        explicit unsafe_indexed_priority_queue(container_type container = container_type()) {
+            for (auto &element: container) {
+                insert(std::move(element.first), std::move(element.second));
+            }
+        }
+
+        poped_value_type pop() {
+            T element{std::move(m_heap.front().value)};
+            remove_at(0u);
+            return element;
+        }
+
+        void push(const pushed_value_type &element) {
+            insert(element.first, element.second);
+        }
+
+        void push(pushed_value_type &&element) {
+            insert(std::move(element.first), std::move(element.second));
+        }
+
+        handle_type push_with_handle(pushed_value_type element) {
+            return insert(std::move(element.first), std::move(element.second));
+        }
+
+        template <class P, class... Args>
+        void emplace(P &&priority, Args&&... args) {
+            insert(std::forward<P>(priority), std::forward<Args>(args)...);
+        }
+
+        // Whether the element of `handle` wasn't popped nor erased yet.
+        bool contains(const handle_type &handle) const {
+            return handle.m_slot < m_slots.size()
+                   && m_slots[handle.m_slot].generation == handle.m_generation
+                   && m_slots[handle.m_slot].position != no_position;
+        }
+
+        // Fails if the element was already popped or erased.
+        bool update_priority(const handle_type &handle, Priority priority) {
+            if (!contains(handle)) {
+                return false;
+            }
+            const auto position = m_slots[handle.m_slot].position;
+            m_heap[position].priority = std::move(priority);
+            restore(position);
+            return true;
+        }
+
+        bool erase(const handle_type &handle) {
+            if (!contains(handle)) {
+                return false;
+            }
+            remove_at(m_slots[handle.m_slot].position);
+            return true;
+        }
+
+        // Priority of the element popped next, the queue mustn't be empty.
+        const Priority &top_priority() const {
+            return m_heap.front().priority;
+        }
+
+        bool empty() const {
+            return m_heap.empty();
+        }
+
+        void clear() {
+            for (const auto &element: m_heap) {
+                release_slot(element.slot);
+            }
+            m_heap.clear();
+        }
+
+        std::size_t size() const {
+            return m_heap.size();
+        }
+    };
+
+    template <class Priority, class T, class Compare>
+    constexpr std::size_t unsafe_indexed_priority_queue<Priority, T, Compare>::no_position;
+}
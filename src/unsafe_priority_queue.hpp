@@ -34,6 +34,11 @@ namespace concurrent {
             m_container.emplace(std::forward<Args>(args)...);
         }
 
+        // Priority of the element popped next, the queue mustn't be empty.
+        const Priority &top_priority() const {
+            return m_container.begin()->first;
+        }
+
         bool empty() const {
             return m_container.empty();
         }
@@ -3,36 +3,81 @@
 #include <condition_variable>
 #include <atomic>
 #include <thread>
+#include <utility>
+#include "blocking_section.hpp"
+#include "local_task_slots.hpp"
 #include "semaphore.hpp"
+#include "staging_lanes.hpp"
+#include "no_instrumentation.hpp"
+#include "mutex_policy.hpp"
 
 namespace concurrent {
-    template<class Queue, class WaitingStrategy, class Thread = std::thread, class Semaphore = semaphore>
+    // Optional parts of a task queue a worker works with, ones left out
+    // aren't used.
+    template <class Task, class ConditionVariable>
+    struct worker_options {
+        // notified when the worker takes a task, only if `waiting_for_room`
+        // counts some pushing threads, if given
+        ConditionVariable *queue_not_full = nullptr;
+        const std::size_t *waiting_for_room = nullptr;
+        local_task_slots<Task> *local_slots = nullptr;
+        std::size_t local_index = 0u;
+        blocking_handler *blocking = nullptr;
+        staging_lanes *lanes = nullptr;
+        std::atomic<std::size_t> *busy_workers = nullptr;
+    };
+
+    template<
+            class Queue,
+            class WaitingStrategy,
+            class Thread = std::thread,
+            class Semaphore = semaphore,
+            class Instrumentation = no_instrumentation,
+            class Mutex = std::mutex
+    >
     class worker {
     public:
         using queue_type = Queue;
         using thread_type = Thread;
         using semaphore_type = Semaphore;
+        using probe_type = typename Instrumentation::worker_probe;
+        using mutex_type = Mutex;
+        using condition_variable_type = condition_variable_for_t<Mutex>;
+        using task_type = decltype(std::declval<queue_type &>().pop());
+        using local_slots_type = local_task_slots<task_type>;
+        using options_type = worker_options<task_type, condition_variable_type>;
 
     private:
         queue_type &m_task_queue;
-        std::mutex &m_mutex;
-        std::condition_variable &m_queue_not_empty;
-        std::condition_variable &m_queue_empty;
-        std::condition_variable &m_thread_exited;
+        mutex_type &m_mutex;
+        condition_variable_type &m_queue_not_empty;
+        condition_variable_type &m_queue_empty;
+        condition_variable_type &m_thread_exited;
         semaphore_type &m_semaphore;
         WaitingStrategy m_waiting_strategy;
+        probe_type m_probe;
+        condition_variable_type *m_queue_not_full;
+        local_slots_type *m_local_slots;
+        std::size_t m_local_index;
+        blocking_handler *m_blocking_handler;
+        const std::size_t *m_waiting_for_room;
+        staging_lanes *m_staging_lanes;
+        std::atomic<std::size_t> *m_busy_workers;
         bool m_stopped{true};
+        std::atomic_bool m_exited{false};
         thread_type m_thread;
 
     public:
         worker(
                 queue_type &task_queue,
-                std::mutex &mutex,
-                std::condition_variable &queue_not_empty,
-                std::condition_variable &queue_empty,
-                std::condition_variable &thread_exited,
+                mutex_type &mutex,
+                condition_variable_type &queue_not_empty,
+                condition_variable_type &queue_empty,
+                condition_variable_type &thread_exited,
                 semaphore_type &sem,
-                WaitingStrategy waiting_strategy = WaitingStrategy()
+                WaitingStrategy waiting_strategy = WaitingStrategy(),
+                probe_type probe = probe_type(),
+                options_type options = options_type()
         ):
                 m_task_queue(task_queue),
                 m_mutex(mutex),
@@ -40,7 +85,15 @@ namespace concurrent {
                 m_queue_empty(queue_empty),
                 m_thread_exited(thread_exited),
                 m_semaphore(sem),
-                m_waiting_strategy(std::move(waiting_strategy)) {
+                m_waiting_strategy(std::move(waiting_strategy)),
+                m_probe(std::move(probe)),
+                m_queue_not_full(options.queue_not_full),
+                m_local_slots(options.local_slots),
+                m_local_index(options.local_index),
+                m_blocking_handler(options.blocking),
+                m_waiting_for_room(options.waiting_for_room),
+                m_staging_lanes(options.lanes),
+                m_busy_workers(options.busy_workers) {
             m_semaphore.release();
         }
 
@@ -51,7 +104,15 @@ namespace concurrent {
             m_queue_empty(other.m_queue_empty),
             m_thread_exited(other.m_thread_exited),
             m_semaphore(other.m_semaphore),
-            m_waiting_strategy(std::move(other.m_waiting_strategy)) {
+            m_waiting_strategy(std::move(other.m_waiting_strategy)),
+            m_probe(std::move(other.m_probe)),
+            m_queue_not_full(other.m_queue_not_full),
+            m_local_slots(other.m_local_slots),
+            m_local_index(other.m_local_index),
+            m_blocking_handler(other.m_blocking_handler),
+            m_waiting_for_room(other.m_waiting_for_room),
+            m_staging_lanes(other.m_staging_lanes),
+            m_busy_workers(other.m_busy_workers) {
 
             try {
                 if (other.running()) {
@@ -64,15 +125,33 @@ namespace concurrent {
             }
         }
 
+        // A worker whose thread has exited is started again.
         void start() {
+            if (m_thread.joinable() && m_exited) {
+                m_thread.join();
+            }
             if (!m_thread.joinable()) {
                 m_stopped = false;
-                m_thread = std::thread{[this] { consume_and_execute(); }};
+                m_exited = false;
+                m_thread = std::thread{[this] {
+                    if (m_local_slots != nullptr) {
+                        m_local_slots->bind(m_local_index);
+                    }
+                    current_blocking_handler() = m_blocking_handler;
+                    consume_and_execute();
+                }};
+            }
+        }
+
+        // Waits until the thread of a stopped worker exits.
+        void join() {
+            if (m_thread.joinable()) {
+                m_thread.join();
             }
         }
 
         bool running() const {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto lock = lock_at(m_mutex, lock_site::other);
             return !m_stopped;
         }
 
@@ -80,8 +159,13 @@ namespace concurrent {
             return !m_stopped;
         }
 
+        // Whether the thread has finished after the worker was stopped.
+        bool exited() const noexcept {
+            return m_exited;
+        }
+
         void stop() {
-            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto lock = lock_at(m_mutex, lock_site::other);
             m_stopped = true;
         }
 
@@ -94,39 +178,135 @@ namespace concurrent {
         }
 
     private:
+        // Queues whose elements expire, like a deadline queue, remove them
+        // only when a worker looks for a task, so they don't become empty
+        // between checking them and popping.
+        template <class Q>
+        static auto remove_expired(Q &queue, int) -> decltype(queue.remove_expired()) {
+            return queue.remove_expired();
+        }
+
+        template <class Q>
+        static bool remove_expired(Q &, long) {
+            return false;
+        }
+
+        bool local_tasks_pending() const {
+            return m_local_slots != nullptr && m_local_slots->any();
+        }
+
+        // Called with the mutex locked. Without the count of pushing threads
+        // waiting for room, any of them might wait.
+        bool waiting_for_room() const noexcept {
+            return m_queue_not_full != nullptr && (m_waiting_for_room == nullptr || *m_waiting_for_room > 0u);
+        }
+
+        // Called with the mutex locked, unlocks it. The worker counts as
+        // busy from then until the task is finished.
+        void execute(std::unique_lock<mutex_type> &lock, task_type &task) {
+            m_semaphore.acquire();
+            if (m_busy_workers != nullptr) {
+                m_busy_workers->fetch_add(1u, std::memory_order_relaxed);
+            }
+
+            const bool notify_empty = m_task_queue.empty() && !local_tasks_pending();
+            const bool notify_not_full = waiting_for_room();
+            lock.unlock();
+
+            if (notify_not_full) {
+                m_queue_not_full->notify_one();
+            }
+            if (notify_empty) {
+                m_queue_empty.notify_one();
+            }
+
+            m_probe.on_task_begin(task);
+            task();
+            m_probe.on_task_end();
+            if (m_busy_workers != nullptr) {
+                m_busy_workers->fetch_sub(1u, std::memory_order_relaxed);
+            }
+            m_semaphore.release();
+        }
+
+        // Called with the mutex locked when the queue is empty, but other
+        // workers have local tasks. Waits for them to become stale, unless
+        // the queue gets a task before.
+        void steal_local_task(std::unique_lock<mutex_type> &lock) {
+            m_probe.on_wait();
+            m_local_slots->begin_search();
+            m_queue_not_empty.wait_for(lock, m_local_slots->steal_delay(), [this] {
+                return !m_task_queue.empty() || m_stopped;
+            });
+            m_local_slots->end_search();
+
+            if (m_task_queue.empty() && !m_stopped) {
+                m_local_slots->steal([this, &lock](task_type &task) { execute(lock, task); });
+            }
+        }
+
+        // Elements staged while the worker was about to wait wouldn't wake
+        // it up, so it looks at registered lanes from time to time.
+        template <class Predicate>
+        bool wait_polling_lanes(std::unique_lock<mutex_type> &lock, const Predicate &predicate) {
+            polling_condition_variable<condition_variable_type> condition_variable(m_queue_not_empty, *m_staging_lanes);
+            return m_waiting_strategy(condition_variable, lock, predicate);
+        }
+
         void consume_and_execute() {
             while (true) {
-                std::unique_lock<std::mutex> lock(m_mutex);
+                auto lock = lock_at(m_mutex, lock_site::pop);
+
+                // task pushed by the previous task of this worker, it's run
+                // even if the worker is stopped
+                const auto run = [this, &lock](task_type &task) { execute(lock, task); };
+                if (m_local_slots != nullptr && m_local_slots->take(m_local_index, run)) {
+                    continue;
+                }
 
-                const auto waiting_result = m_waiting_strategy(
-                        m_queue_not_empty,
-                        lock,
-                        [this] {
-                            return !m_task_queue.empty() || m_stopped;
+                const auto ready = [this] {
+                    if (remove_expired(m_task_queue, 0)) {
+                        if (waiting_for_room()) {
+                            m_queue_not_full->notify_all();
                         }
-                );
+                        if (m_task_queue.empty() && !local_tasks_pending()) {
+                            m_queue_empty.notify_one();
+                        }
+                    }
+                    return !m_task_queue.empty() || m_stopped
+                           || (local_tasks_pending() && !m_local_slots->searching())
+                           || (m_staging_lanes != nullptr && m_staging_lanes->unstage_lanes());
+                };
+                // the probe is told only when the worker is going to wait,
+                // so it needn't read the clock between consecutive tasks
+                const auto ready_or_waiting = [this, &ready] {
+                    if (ready()) {
+                        return true;
+                    }
+                    m_probe.on_wait();
+                    return false;
+                };
+                const auto waiting_result = m_staging_lanes != nullptr
+                        ? wait_polling_lanes(lock, ready_or_waiting)
+                        : m_waiting_strategy(m_queue_not_empty, lock, ready_or_waiting);
 
                 if (m_stopped || !waiting_result) {
                     m_stopped = true;
                     break;
                 }
 
-                auto task = m_task_queue.pop();
-                m_semaphore.acquire();
-
-                const bool notify_empty = m_task_queue.empty();
-                lock.unlock();
-
-                if (notify_empty) {
-                    m_queue_empty.notify_one();
+                if (m_task_queue.empty()) {
+                    if (m_local_slots != nullptr) {
+                        steal_local_task(lock);
+                    }
+                    continue;
                 }
 
-                task();
-                m_semaphore.release();
+                auto task = m_task_queue.pop();
+                execute(lock, task);
             }
+            m_exited = true;
             m_thread_exited.notify_one();
         }
     };
 }
-
-
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace concurrent {
+    // Registry of per-worker data used by instrumentation policies.
+    // Slots are allocated by one thread at a time (workers are created under
+    // the queue lock) and can be read concurrently without locking. Slots of
+    // destroyed workers are reused, so the number of slots is bounded by the
+    // number of workers alive at once.
+    template <class Slot>
+    class worker_slots {
+        const std::size_t m_capacity;
+        std::unique_ptr<std::atomic<Slot *>[]> m_slots;
+        std::unique_ptr<std::atomic_bool[]> m_in_use;
+        std::atomic<std::size_t> m_size;
+
+    public:
+        explicit worker_slots(std::size_t capacity):
+                m_capacity(capacity),
+                m_slots(new std::atomic<Slot *>[capacity]),
+                m_in_use(new std::atomic_bool[capacity]),
+                m_size(0u) {
+            for (auto i = 0u; i < m_capacity; ++i) {
+                m_slots[i].store(nullptr, std::memory_order_relaxed);
+                m_in_use[i].store(false, std::memory_order_relaxed);
+            }
+        }
+
+        worker_slots(const worker_slots &) = delete;
+        worker_slots &operator=(const worker_slots &) = delete;
+
+        ~worker_slots() {
+            for (auto i = 0u; i < m_capacity; ++i) {
+                delete m_slots[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        // Returns index of acquired slot or `capacity()` if all slots are in use.
+        template <class ...Args>
+        std::size_t acquire(Args && ...args) {
+            const auto size = m_size.load(std::memory_order_relaxed);
+
+            for (auto i = 0u; i < size; ++i) {
+                bool expected = false;
+                if (m_in_use[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return i;
+                }
+            }
+
+            if (size == m_capacity) {
+                return m_capacity;
+            }
+
+            m_in_use[size].store(true, std::memory_order_relaxed);
+            m_slots[size].store(new Slot(std::forward<Args>(args)...), std::memory_order_release);
+            m_size.store(size + 1u, std::memory_order_release);
+            return size;
+        }
+
+        void release(std::size_t index) noexcept {
+            m_in_use[index].store(false, std::memory_order_release);
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_capacity;
+        }
+
+        std::size_t size() const noexcept {
+            return m_size.load(std::memory_order_acquire);
+        }
+
+        Slot &operator[](std::size_t index) noexcept {
+            return *m_slots[index].load(std::memory_order_acquire);
+        }
+
+        const Slot &operator[](std::size_t index) const noexcept {
+            return *m_slots[index].load(std::memory_order_acquire);
+        }
+    };
+}
+
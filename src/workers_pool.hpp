@@ -59,6 +59,14 @@ namespace concurrent {
             m_container.emplace_back(std::forward<Args>(args)...);
         }
 
+        worker_type &operator[](size_type index) {
+            return m_container[index];
+        }
+
+        const worker_type &operator[](size_type index) const {
+            return m_container[index];
+        }
+
         worker_type &back() {
             return m_container.back();
         }
@@ -79,12 +87,19 @@ namespace concurrent {
             }
         }
 
-        void remove_stopped() {
-            for (auto it = begin(); it != end(); ++it) {
+        size_type remove_stopped() {
+            size_type removed = 0u;
+
+            for (auto it = begin(); it != end();) {
                 if (!it->nonblocking_running()) {
                     it = m_container.erase(it);
+                    ++removed;
+                } else {
+                    ++it;
                 }
             }
+
+            return removed;
         }
 
         std::size_t stopped_count() const {
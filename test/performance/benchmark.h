@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal benchmarking harness shared by performance targets: warmup,
+// repetitions, percentiles and machine-readable JSON report.
+namespace benchmark {
+    using clock_type = std::chrono::steady_clock;
+
+    using parameters_type = std::vector<std::pair<std::string, double>>;
+
+    template <class Duration>
+    double to_ns(Duration duration) {
+        return std::chrono::duration<double, std::nano>(duration).count();
+    }
+
+    struct statistics {
+        std::size_t samples;
+        double min;
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double p999;
+        double max;
+    };
+
+    // nearest-rank percentile of sorted values
+    inline double percentile(const std::vector<double> &sorted, double percent) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+
+        const auto rank = static_cast<std::size_t>(std::ceil(percent / 100.0 * sorted.size()));
+        return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1u)) - 1u];
+    }
+
+    inline statistics summarize(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+
+        double sum = 0.0;
+        for (auto value: values) {
+            sum += value;
+        }
+
+        return {
+                values.size(),
+                values.empty() ? 0.0 : values.front(),
+                values.empty() ? 0.0 : sum / values.size(),
+                percentile(values, 50.0),
+                percentile(values, 90.0),
+                percentile(values, 99.0),
+                percentile(values, 99.9),
+                values.empty() ? 0.0 : values.back()
+        };
+    }
+
+    struct options {
+        std::size_t warmup = 2u;
+        // samples of throughput-like benchmarks, every one is a full run
+        std::size_t repetitions = 10u;
+        // samples of latency-like benchmarks, every one is a single operation
+        std::size_t samples = 10000u;
+        std::size_t tasks = 100000u;
+        std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::string filter;
+        std::string output;
+
+        static options parse(int argc, char **argv) {
+            options result;
+
+            for (auto i = 1; i + 1 < argc; i += 2) {
+                const std::string name = argv[i];
+                const std::string value = argv[i + 1];
+
+                if (name == "--warmup") {
+                    result.warmup = std::stoul(value);
+                } else if (name == "--repetitions") {
+                    result.repetitions = std::max(1ul, std::stoul(value));
+                } else if (name == "--samples") {
+                    result.samples = std::max(1ul, std::stoul(value));
+                } else if (name == "--tasks") {
+                    result.tasks = std::max(1ul, std::stoul(value));
+                } else if (name == "--max-threads") {
+                    result.max_threads = std::max(1ul, std::stoul(value));
+                } else if (name == "--filter") {
+                    result.filter = value;
+                } else if (name == "--out") {
+                    result.output = value;
+                } else {
+                    std::cerr << "unknown option " << name << std::endl;
+                }
+            }
+
+            return result;
+        }
+
+        // 1, 2, 4, ... up to and including `max_threads`
+        std::vector<std::size_t> thread_counts() const {
+            std::vector<std::size_t> counts;
+            for (std::size_t count = 1u; count < max_threads; count *= 2u) {
+                counts.push_back(count);
+            }
+            counts.push_back(max_threads);
+            return counts;
+        }
+
+        bool enabled(const std::string &name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        parameters_type context() const {
+            return {{"warmup", warmup}, {"repetitions", repetitions}, {"samples", samples}, {"tasks", tasks}};
+        }
+    };
+
+    // Calls `function` returning a single sample `warmup + count` times,
+    // samples of warmup calls are dropped.
+    template <class Function>
+    std::vector<double> repeat(std::size_t warmup, std::size_t count, Function &&function) {
+        for (auto i = 0u; i < warmup; ++i) {
+            function();
+        }
+
+        std::vector<double> samples;
+        samples.reserve(count);
+        for (auto i = 0u; i < count; ++i) {
+            samples.push_back(function());
+        }
+        return samples;
+    }
+
+    struct result {
+        std::string name;
+        std::string subject;
+        parameters_type parameters;
+        std::string unit;
+        statistics stats;
+    };
+
+    class report {
+        std::vector<result> m_results;
+        bool m_print_summaries;
+
+        static void write_string(std::ostream &stream, const std::string &text) {
+            stream << '"';
+            for (auto c: text) {
+                if (c == '"' || c == '\\') {
+                    stream << '\\';
+                }
+                stream << c;
+            }
+            stream << '"';
+        }
+
+        static std::string current_time() {
+            char buffer[32];
+            const auto now = std::time(nullptr);
+            std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+            return buffer;
+        }
+
+    public:
+        explicit report(bool print_summaries = true):
+                m_results(),
+                m_print_summaries(print_summaries) {
+
+        }
+
+        // Adds result and prints its summary to standard error.
+        void add(
+                std::string name,
+                std::string subject,
+                parameters_type parameters,
+                std::string unit,
+                std::vector<double> samples
+        ) {
+            result added{
+                    std::move(name),
+                    std::move(subject),
+                    std::move(parameters),
+                    std::move(unit),
+                    summarize(std::move(samples))
+            };
+
+            if (m_print_summaries) {
+                std::cerr << added.name << " " << added.subject;
+                for (const auto &parameter: added.parameters) {
+                    std::cerr << " " << parameter.first << "=" << parameter.second;
+                }
+                std::cerr << ": p50 " << added.stats.p50 << " p99 " << added.stats.p99
+                          << " max " << added.stats.max << " " << added.unit << std::endl;
+            }
+
+            m_results.push_back(std::move(added));
+        }
+
+        const std::vector<result> &results() const noexcept {
+            return m_results;
+        }
+
+        // Besides given context, date, compiler and machine are written.
+        void write_json(std::ostream &stream, const parameters_type &context) const {
+            stream << "{\n  \"context\": {\"date\": ";
+            write_string(stream, current_time());
+            stream << ", \"compiler\": ";
+            write_string(stream, __VERSION__);
+            stream << ", \"hardware_concurrency\": " << std::thread::hardware_concurrency();
+            for (const auto &parameter: context) {
+                stream << ", ";
+                write_string(stream, parameter.first);
+                stream << ": " << parameter.second;
+            }
+            stream << "},\n  \"benchmarks\": [";
+
+            const char *separator = "\n";
+            for (const auto &added: m_results) {
+                stream << separator << "    {\"name\": ";
+                write_string(stream, added.name);
+                stream << ", \"subject\": ";
+                write_string(stream, added.subject);
+                stream << ", \"parameters\": {";
+                const char *parameter_separator = "";
+                for (const auto &parameter: added.parameters) {
+                    stream << parameter_separator;
+                    write_string(stream, parameter.first);
+                    stream << ": " << parameter.second;
+                    parameter_separator = ", ";
+                }
+                stream << "}, \"unit\": ";
+                write_string(stream, added.unit);
+                stream << ", \"samples\": " << added.stats.samples
+                       << ", \"min\": " << added.stats.min
+                       << ", \"mean\": " << added.stats.mean
+                       << ", \"p50\": " << added.stats.p50
+                       << ", \"p90\": " << added.stats.p90
+                       << ", \"p99\": " << added.stats.p99
+                       << ", \"p999\": " << added.stats.p999
+                       << ", \"max\": " << added.stats.max << "}";
+                separator = ",\n";
+            }
+            stream << "\n  ]\n}\n";
+        }
+
+        // Writes report to given file or to standard output if path is empty.
+        bool write_json(const std::string &path, const parameters_type &context) const {
+            if (path.empty()) {
+                write_json(std::cout, context);
+                return static_cast<bool>(std::cout);
+            }
+
+            std::ofstream file(path);
+            write_json(file, context);
+            return static_cast<bool>(file);
+        }
+    };
+}
@@ -0,0 +1,375 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <task_queues.hpp>
+#include <parallel_for_each.hpp>
+#include <no_instrumentation.hpp>
+#include <queue_metrics.hpp>
+#include <chrome_tracing.hpp>
+#include "benchmark.h"
+#include "queue_aliases.h"
+
+namespace {
+    using benchmark::clock_type;
+    using benchmark::to_ns;
+    using queue_aliases::is_priority_queue;
+    using queue_aliases::push_task;
+    using queue_aliases::push_task_with_result;
+    using queue_aliases::for_each_task;
+    using queue_aliases::instrumented_t;
+
+    // Some work, which cannot be optimized out.
+    void spin(unsigned iterations) {
+        volatile unsigned counter = 0u;
+        for (auto i = 0u; i < iterations; ++i) {
+            counter = counter + 1u;
+        }
+    }
+
+    template <class TaskQueue>
+    class suite {
+        using factory_type = std::function<std::unique_ptr<TaskQueue>(std::size_t)>;
+
+        const benchmark::options &m_options;
+        benchmark::report &m_report;
+        const std::string m_subject;
+        const factory_type m_factory;
+
+        bool enabled(const std::string &name) const {
+            return m_options.enabled(name + "/" + m_subject);
+        }
+
+        void add(const std::string &name, benchmark::parameters_type parameters,
+                 const std::string &unit, std::vector<double> samples) {
+            m_report.add(name, m_subject, std::move(parameters), unit, std::move(samples));
+        }
+
+    public:
+        suite(const benchmark::options &options, benchmark::report &report, std::string subject, factory_type factory):
+                m_options(options),
+                m_report(report),
+                m_subject(std::move(subject)),
+                m_factory(std::move(factory)) {
+
+        }
+
+        // Time to push and execute a task doing nothing.
+        void empty_task_throughput() {
+            if (!enabled("empty_task_throughput")) {
+                return;
+            }
+
+            const auto tasks = m_options.tasks;
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+                auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                    const auto begin = clock_type::now();
+                    for (auto i = 0u; i < tasks; ++i) {
+                        push_task(*queue, [] {});
+                    }
+                    queue->wait_for_tasks_completion();
+                    return to_ns(clock_type::now() - begin) / tasks;
+                });
+                add("empty_task_throughput", {{"threads", threads}}, "ns/task", std::move(samples));
+            }
+        }
+
+        // Duration of a single push call, includes ~20ns of clock overhead.
+        void push_latency() {
+            if (!enabled("push_latency")) {
+                return;
+            }
+
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+                std::size_t pushed = 0u;
+                auto samples = benchmark::repeat(m_options.warmup, m_options.samples, [&] {
+                    const auto begin = clock_type::now();
+                    push_task(*queue, [] {});
+                    const auto end = clock_type::now();
+
+                    // keep queue short, so samples don't depend on its length
+                    if (++pushed % 1024u == 0u) {
+                        queue->wait_for_tasks_completion();
+                    }
+                    return to_ns(end - begin);
+                });
+                add("push_latency", {{"threads", threads}}, "ns", std::move(samples));
+            }
+        }
+
+        // Round of many small tasks joined by the last finished one.
+        void fan_out_fan_in() {
+            if (!enabled("fan_out_fan_in")) {
+                return;
+            }
+
+            constexpr auto width = 256u;
+            const auto rounds = std::max<std::size_t>(m_options.repetitions, m_options.samples / width);
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+                auto samples = benchmark::repeat(m_options.warmup, rounds, [&] {
+                    std::atomic<unsigned> remaining{width};
+                    std::promise<void> joined;
+                    auto joined_future = joined.get_future();
+
+                    const auto begin = clock_type::now();
+                    for (auto i = 0u; i < width; ++i) {
+                        push_task(*queue, [&remaining, &joined] {
+                            spin(64u);
+                            if (--remaining == 0u) {
+                                joined.set_value();
+                            }
+                        });
+                    }
+                    joined_future.wait();
+                    return to_ns(clock_type::now() - begin);
+                });
+                add("fan_out_fan_in", {{"threads", threads}, {"width", width}}, "ns/round", std::move(samples));
+            }
+        }
+
+        // Many producers pushing at once to queue with many workers.
+        void producer_consumer_contention() {
+            if (!enabled("producer_consumer_contention")) {
+                return;
+            }
+
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+
+                for (auto producers: m_options.thread_counts()) {
+                    const auto tasks_per_producer = m_options.tasks / producers;
+                    const auto tasks = tasks_per_producer * producers;
+
+                    auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                        std::atomic<std::size_t> ready{0u};
+                        std::atomic_bool go{false};
+                        std::vector<std::thread> producer_threads;
+
+                        for (auto i = 0u; i < producers; ++i) {
+                            producer_threads.emplace_back([&] {
+                                ++ready;
+                                while (!go.load(std::memory_order_acquire)) {
+                                    std::this_thread::yield();
+                                }
+                                for (auto j = 0u; j < tasks_per_producer; ++j) {
+                                    push_task(*queue, [] {});
+                                }
+                            });
+                        }
+                        while (ready.load() != producers) {
+                            std::this_thread::yield();
+                        }
+
+                        const auto begin = clock_type::now();
+                        go.store(true, std::memory_order_release);
+                        for (auto &thread: producer_threads) {
+                            thread.join();
+                        }
+                        queue->wait_for_tasks_completion();
+                        return to_ns(clock_type::now() - begin) / tasks;
+                    });
+                    add(
+                            "producer_consumer_contention",
+                            {{"threads", threads}, {"producers", producers}},
+                            "ns/task",
+                            std::move(samples)
+                    );
+                }
+            }
+        }
+
+        // Round trip of a single task with result and cost of pushing many.
+        void push_with_result() {
+            if (!enabled("push_with_result")) {
+                return;
+            }
+
+            const auto tasks = m_options.tasks;
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+
+                auto round_trip = benchmark::repeat(m_options.warmup, m_options.samples, [&] {
+                    const auto begin = clock_type::now();
+                    push_task_with_result(*queue, [] { return 1; }).get();
+                    return to_ns(clock_type::now() - begin);
+                });
+                add("push_with_result_round_trip", {{"threads", threads}}, "ns", std::move(round_trip));
+
+                auto throughput = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                    std::vector<std::future<int>> results;
+                    results.reserve(tasks);
+
+                    const auto begin = clock_type::now();
+                    for (auto i = 0u; i < tasks; ++i) {
+                        results.push_back(push_task_with_result(*queue, [] { return 1; }));
+                    }
+                    for (auto &result: results) {
+                        result.get();
+                    }
+                    return to_ns(clock_type::now() - begin) / tasks;
+                });
+                add("push_with_result_throughput", {{"threads", threads}}, "ns/task", std::move(throughput));
+            }
+        }
+
+        void parallel_for_each_scaling() {
+            if (!enabled("parallel_for_each")) {
+                return;
+            }
+
+            std::vector<int> elements(m_options.tasks);
+            std::iota(elements.begin(), elements.end(), 0);
+
+            for (auto threads: m_options.thread_counts()) {
+                auto queue = m_factory(threads);
+                auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                    const auto begin = clock_type::now();
+                    for_each_task(*queue, elements.begin(), elements.end(), [](int &element) {
+                        spin(256u);
+                        element = element * 3 + 1;
+                    }, is_priority_queue<TaskQueue>());
+                    return to_ns(clock_type::now() - begin) / elements.size();
+                });
+                add("parallel_for_each", {{"threads", threads}}, "ns/element", std::move(samples));
+            }
+        }
+
+        void run() {
+            empty_task_throughput();
+            push_latency();
+            fan_out_fan_in();
+            producer_consumer_contention();
+            push_with_result();
+            parallel_for_each_scaling();
+        }
+    };
+
+    // Empty task throughput of the alias rebound to `Instrumentation`.
+    template <class Instrumentation, class Alias>
+    void instrumented_throughput(
+            const Alias &alias,
+            const char *instrumentation,
+            const benchmark::options &options,
+            benchmark::report &report
+    ) {
+        using task_queue_type = instrumented_t<typename Alias::task_queue_type, Instrumentation>;
+        const std::string subject = std::string(alias.name) + "/" + instrumentation;
+        if (!options.enabled("instrumentation_overhead/" + subject)) {
+            return;
+        }
+
+        const typename Alias::template rebind<task_queue_type> instrumented_alias{alias.name};
+        const auto tasks = options.tasks;
+        for (auto threads: options.thread_counts()) {
+            auto queue = instrumented_alias.make(threads);
+            auto samples = benchmark::repeat(options.warmup, options.repetitions, [&] {
+                const auto begin = clock_type::now();
+                for (auto i = 0u; i < tasks; ++i) {
+                    push_task(*queue, [] {});
+                }
+                queue->wait_for_tasks_completion();
+                return to_ns(clock_type::now() - begin) / tasks;
+            });
+            report.add("instrumentation_overhead", subject, {{"threads", threads}}, "ns/task", std::move(samples));
+        }
+    }
+
+    // Cost of instrumentation policies per task, compared with the same
+    // alias without instrumentation. Queues without the policy are skipped.
+    template <class Alias>
+    void instrumentation_overhead(const Alias &, const benchmark::options &, benchmark::report &, std::true_type) {
+    }
+
+    template <class Alias>
+    void instrumentation_overhead(
+            const Alias &alias,
+            const benchmark::options &options,
+            benchmark::report &report,
+            std::false_type
+    ) {
+        instrumented_throughput<concurrent::no_instrumentation>(alias, "no_instrumentation", options, report);
+        instrumented_throughput<concurrent::queue_metrics>(alias, "queue_metrics", options, report);
+        instrumented_throughput<concurrent::chrome_tracing>(alias, "chrome_tracing", options, report);
+    }
+
+    template <class Alias>
+    void instrumentation_overhead(const Alias &alias, const benchmark::options &options, benchmark::report &report) {
+        using task_queue_type = typename Alias::task_queue_type;
+        instrumentation_overhead(
+                alias,
+                options,
+                report,
+                std::is_void<instrumented_t<task_queue_type, concurrent::no_instrumentation>>()
+        );
+    }
+
+    // Time of constructing the queue and from construction to first task.
+    void startup(const benchmark::options &options, benchmark::report &report) {
+        const std::pair<concurrent::startup_policy, const char *> policies[] = {
+                {concurrent::startup_policy::eager, "eager"},
+                {concurrent::startup_policy::parallel, "parallel"},
+                {concurrent::startup_policy::lazy, "lazy"}
+        };
+
+        for (const auto &policy: policies) {
+            const std::string subject = std::string("n_threaded_fifo_task_queue/") + policy.second;
+            if (!options.enabled("startup/" + subject)) {
+                continue;
+            }
+
+            for (std::size_t threads: {4u, 16u, 128u}) {
+                std::vector<double> construction;
+                auto first_task = benchmark::repeat(options.warmup, options.repetitions, [&] {
+                    std::promise<clock_type::time_point> first_task_started;
+                    auto first_task_started_future = first_task_started.get_future();
+
+                    const auto begin = clock_type::now();
+                    concurrent::n_threaded_fifo_task_queue queue(
+                            threads,
+                            concurrent::n_threaded_fifo_task_queue::queue_type(),
+                            policy.first
+                    );
+                    const auto constructed = clock_type::now();
+
+                    queue.push([&first_task_started] { first_task_started.set_value(clock_type::now()); });
+                    const auto started = first_task_started_future.get();
+
+                    construction.push_back(to_ns(constructed - begin));
+                    return to_ns(started - begin);
+                });
+                construction.erase(construction.begin(), construction.begin() + options.warmup);
+
+                report.add("startup_construction", subject, {{"threads", threads}}, "ns", std::move(construction));
+                report.add("startup_first_task", subject, {{"threads", threads}}, "ns", std::move(first_task));
+            }
+        }
+    }
+}
+
+// usage: thread_pool_benchmarks [--out file.json] [--filter name/subject]
+//        [--max-threads N] [--tasks N] [--repetitions N] [--samples N] [--warmup N]
+int main(int argc, char **argv) {
+    const auto options = benchmark::options::parse(argc, argv);
+    benchmark::report report;
+
+    queue_aliases::for_each([&](const auto &alias) {
+        using task_queue_type = typename std::decay_t<decltype(alias)>::task_queue_type;
+        suite<task_queue_type>(options, report, alias.name, [&alias](std::size_t threads) {
+            return alias.make(threads);
+        }).run();
+        instrumentation_overhead(alias, options, report);
+    });
+    startup(options, report);
+
+    return report.write_json(options.output, options.context()) ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <channel.hpp>
+#include "benchmark.h"
+
+// Channels compared with a bounded mutex and deque channel they replace.
+namespace {
+    using benchmark::clock_type;
+    using benchmark::to_ns;
+
+    class mutex_deque_channel {
+        std::mutex m_mutex;
+        std::condition_variable m_not_empty;
+        std::condition_variable m_not_full;
+        std::deque<int> m_values;
+        const std::size_t m_capacity;
+        bool m_closed{false};
+
+    public:
+        explicit mutex_deque_channel(std::size_t capacity):
+                m_capacity(capacity) {
+
+        }
+
+        bool send(int value) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [this] { return m_values.size() < m_capacity || m_closed; });
+            if (m_closed) {
+                return false;
+            }
+            m_values.push_back(value);
+            lock.unlock();
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        bool recv(int &value) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty.wait(lock, [this] { return !m_values.empty() || m_closed; });
+            if (m_values.empty()) {
+                return false;
+            }
+            value = m_values.front();
+            m_values.pop_front();
+            lock.unlock();
+            m_not_full.notify_one();
+            return true;
+        }
+
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_not_empty.notify_all();
+            m_not_full.notify_all();
+        }
+    };
+
+    template <class Channel>
+    class channel_suite {
+        const benchmark::options &m_options;
+        benchmark::report &m_report;
+        const std::string m_subject;
+
+    public:
+        channel_suite(const benchmark::options &options, benchmark::report &report, std::string subject):
+                m_options(options),
+                m_report(report),
+                m_subject(std::move(subject)) {
+
+        }
+
+        // Values sent by `producers` threads and received by `consumers`
+        // threads through a channel of given capacity.
+        void throughput(std::size_t producers, std::size_t consumers, std::size_t capacity) {
+            if (!m_options.enabled("throughput/" + m_subject)) {
+                return;
+            }
+
+            const auto values_per_producer = m_options.tasks / producers;
+            auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                Channel channel(capacity);
+                std::vector<std::thread> threads;
+
+                const auto begin = clock_type::now();
+                for (auto i = 0u; i < consumers; ++i) {
+                    threads.emplace_back([&channel] {
+                        int value = 0;
+                        while (channel.recv(value)) {
+                        }
+                    });
+                }
+                std::vector<std::thread> sending;
+                for (auto i = 0u; i < producers; ++i) {
+                    sending.emplace_back([&channel, values_per_producer] {
+                        for (auto j = 0u; j < values_per_producer; ++j) {
+                            channel.send(static_cast<int>(j));
+                        }
+                    });
+                }
+                for (auto &thread: sending) {
+                    thread.join();
+                }
+                channel.close();
+                for (auto &thread: threads) {
+                    thread.join();
+                }
+                return to_ns(clock_type::now() - begin) / (values_per_producer * producers);
+            });
+            m_report.add(
+                    "throughput",
+                    m_subject,
+                    {{"producers", producers}, {"consumers", consumers}, {"capacity", capacity}},
+                    "ns/value",
+                    std::move(samples)
+            );
+        }
+
+        void run(bool single_producer_single_consumer_only) {
+            for (std::size_t capacity: {16u, 1024u}) {
+                throughput(1u, 1u, capacity);
+                if (single_producer_single_consumer_only) {
+                    continue;
+                }
+                for (auto threads: m_options.thread_counts()) {
+                    if (threads > 1u) {
+                        throughput(threads, threads, capacity);
+                    }
+                }
+            }
+        }
+    };
+}
+
+// usage: thread_pool_channel_benchmarks [--out file.json] [--filter scenario/channel]
+//        [--max-threads N] [--tasks N] [--repetitions N] [--warmup N]
+int main(int argc, char **argv) {
+    const auto options = benchmark::options::parse(argc, argv);
+    benchmark::report report;
+
+    channel_suite<mutex_deque_channel>(options, report, "mutex+deque").run(false);
+    channel_suite<concurrent::channel<int>>(options, report, "channel").run(false);
+    channel_suite<concurrent::spsc_channel<int>>(options, report, "spsc_channel").run(true);
+
+    return report.write_json(options.output, options.context()) ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "benchmark.h"
+#include "queue_aliases.h"
+
+// Open-loop load generator: tasks arrive on a schedule independent of how
+// fast the queue executes them, so queueing delay shows up in latency.
+// Latency is measured from the scheduled arrival time, not from the time
+// the task was actually pushed, which corrects for coordinated omission
+// when the generator itself falls behind.
+namespace {
+    using benchmark::clock_type;
+
+    struct load_options {
+        std::string arrival = "poisson";
+        std::string distribution = "exponential";
+        double mean_task_us = 50.0;
+        double seconds = 1.0;
+        // tasks scheduled in the first part of every run aren't measured
+        double warmup_fraction = 0.1;
+        std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<double> rates;
+        std::string filter;
+        std::string output;
+        std::uint64_t seed = 42u;
+
+        static load_options parse(int argc, char **argv) {
+            load_options result;
+
+            for (auto i = 1; i + 1 < argc; i += 2) {
+                const std::string name = argv[i];
+                const std::string value = argv[i + 1];
+
+                if (name == "--arrival") {
+                    result.arrival = value;
+                } else if (name == "--distribution") {
+                    result.distribution = value;
+                } else if (name == "--mean-task-us") {
+                    result.mean_task_us = std::max(0.0, std::stod(value));
+                } else if (name == "--seconds") {
+                    result.seconds = std::max(0.001, std::stod(value));
+                } else if (name == "--threads") {
+                    result.threads = std::max(1ul, std::stoul(value));
+                } else if (name == "--rates") {
+                    std::istringstream rates(value);
+                    std::string rate;
+                    while (std::getline(rates, rate, ',')) {
+                        result.rates.push_back(std::stod(rate));
+                    }
+                } else if (name == "--filter") {
+                    result.filter = value;
+                } else if (name == "--out") {
+                    result.output = value;
+                } else if (name == "--seed") {
+                    result.seed = std::stoull(value);
+                } else {
+                    std::cerr << "unknown option " << name << std::endl;
+                }
+            }
+
+            if (result.rates.empty()) {
+                result.rates = default_rates(result);
+            }
+
+            return result;
+        }
+
+        // Fractions of estimated capacity of the queue, up to overload.
+        static std::vector<double> default_rates(const load_options &options) {
+            const auto cores = std::max(1u, std::thread::hardware_concurrency());
+            const auto busy_threads = std::min<std::size_t>(options.threads, cores);
+            const auto capacity = busy_threads * 1e6 / std::max(1.0, options.mean_task_us);
+
+            std::vector<double> rates;
+            for (auto fraction: {0.1, 0.25, 0.5, 0.7, 0.8, 0.9, 0.95, 1.0, 1.1}) {
+                rates.push_back(fraction * capacity);
+            }
+            return rates;
+        }
+
+        benchmark::parameters_type context() const {
+            return {
+                    {"threads", threads},
+                    {"mean_task_us", mean_task_us},
+                    {"seconds", seconds},
+                    {"warmup_fraction", warmup_fraction},
+                    {"poisson_arrival", arrival == "poisson" ? 1.0 : 0.0}
+            };
+        }
+    };
+
+    // Scheduled arrivals and durations of all tasks, generated up front so
+    // the generator loop only waits and pushes.
+    struct schedule {
+        std::vector<std::int64_t> arrival_ns;
+        std::vector<std::int64_t> duration_ns;
+    };
+
+    schedule make_schedule(const load_options &options, double rate) {
+        const auto count = std::max<std::size_t>(1u, static_cast<std::size_t>(rate * options.seconds));
+        const auto mean_ns = options.mean_task_us * 1e3;
+        std::mt19937_64 random(options.seed);
+        std::exponential_distribution<double> interarrival(rate / 1e9);
+        std::exponential_distribution<double> exponential_duration(mean_ns > 0.0 ? 1.0 / mean_ns : 1.0);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        schedule result;
+        result.arrival_ns.reserve(count);
+        result.duration_ns.reserve(count);
+
+        double time = 0.0;
+        for (auto i = 0u; i < count; ++i) {
+            time += options.arrival == "poisson" ? interarrival(random) : 1e9 / rate;
+            result.arrival_ns.push_back(static_cast<std::int64_t>(time));
+
+            double duration = mean_ns;
+            if (options.distribution == "exponential") {
+                duration = exponential_duration(random);
+            } else if (options.distribution == "uniform") {
+                duration = uniform(random) * 2.0 * mean_ns;
+            } else if (options.distribution == "bimodal") {
+                // 90% of short tasks and 10% of 10 times longer ones
+                const auto short_duration = mean_ns / 1.9;
+                duration = uniform(random) < 0.9 ? short_duration : 10.0 * short_duration;
+            }
+            result.duration_ns.push_back(static_cast<std::int64_t>(duration));
+        }
+
+        return result;
+    }
+
+    std::int64_t since(clock_type::time_point begin) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count();
+    }
+
+    void wait_until(clock_type::time_point begin, std::int64_t offset_ns) {
+        const auto remaining = offset_ns - since(begin);
+        if (remaining > 200000) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - 100000));
+        }
+        while (since(begin) < offset_ns) {
+        }
+    }
+
+    // Times of every task relative to the beginning of run, every entry
+    // is written by the single task it belongs to.
+    struct run_record {
+        std::vector<std::int64_t> pushed_ns;
+        std::vector<std::int64_t> started_ns;
+        std::vector<std::int64_t> finished_ns;
+    };
+
+    template <class TaskQueue>
+    void run_rate(
+            TaskQueue &queue,
+            const char *subject,
+            const load_options &options,
+            double rate,
+            benchmark::report &report
+    ) {
+        const auto planned = make_schedule(options, rate);
+        const auto count = planned.arrival_ns.size();
+        run_record record{
+                std::vector<std::int64_t>(count),
+                std::vector<std::int64_t>(count),
+                std::vector<std::int64_t>(count)
+        };
+
+        const auto begin = clock_type::now();
+        for (auto i = 0u; i < count; ++i) {
+            wait_until(begin, planned.arrival_ns[i]);
+            record.pushed_ns[i] = since(begin);
+
+            const auto task_record = &record;
+            const auto duration = planned.duration_ns[i];
+            queue_aliases::push_task(queue, [task_record, begin, duration, i] {
+                const auto started = since(begin);
+                task_record->started_ns[i] = started;
+                while (since(begin) - started < duration) {
+                }
+                task_record->finished_ns[i] = since(begin);
+            });
+        }
+        queue.wait_for_tasks_completion();
+
+        const auto first_measured = static_cast<std::size_t>(count * options.warmup_fraction);
+        std::vector<double> queue_wait;
+        std::vector<double> uncorrected_queue_wait;
+        std::vector<double> sojourn;
+        std::int64_t last_finished = 0;
+        for (auto i = first_measured; i < count; ++i) {
+            queue_wait.push_back((record.started_ns[i] - planned.arrival_ns[i]) / 1e3);
+            uncorrected_queue_wait.push_back((record.started_ns[i] - record.pushed_ns[i]) / 1e3);
+            sojourn.push_back((record.finished_ns[i] - planned.arrival_ns[i]) / 1e3);
+        }
+        for (auto finished: record.finished_ns) {
+            last_finished = std::max(last_finished, finished);
+        }
+
+        const auto achieved = count / (last_finished / 1e9);
+        const benchmark::parameters_type parameters = {
+                {"offered_rate", rate},
+                {"achieved_rate", achieved},
+                {"threads", options.threads}
+        };
+        report.add("queue_wait", subject, parameters, "us", std::move(queue_wait));
+        const auto wait = report.results().back().stats;
+        report.add("queue_wait_uncorrected", subject, parameters, "us", std::move(uncorrected_queue_wait));
+        report.add("sojourn", subject, parameters, "us", std::move(sojourn));
+        const auto total = report.results().back().stats;
+
+        std::ostringstream row;
+        row << std::fixed << std::setprecision(1)
+            << std::setw(12) << rate << std::setw(12) << achieved
+            << std::setw(10) << wait.p50 << std::setw(10) << wait.p90
+            << std::setw(10) << wait.p99 << std::setw(10) << wait.p999 << std::setw(12) << wait.max
+            << std::setw(12) << total.p99;
+        std::cout << row.str() << std::endl;
+    }
+}
+
+// usage: thread_pool_load_generator [--arrival poisson|fixed]
+//        [--distribution exponential|fixed|uniform|bimodal] [--mean-task-us 50]
+//        [--rates 1000,2000,...] [--seconds 1] [--threads N] [--filter alias]
+//        [--out file.json] [--seed 42]
+int main(int argc, char **argv) {
+    const auto options = load_options::parse(argc, argv);
+    benchmark::report report(false);
+
+    queue_aliases::for_each([&](const auto &alias) {
+        if (!options.filter.empty() && std::string(alias.name).find(options.filter) == std::string::npos) {
+            return;
+        }
+
+        std::cout << alias.name << ", " << options.threads << " threads, " << options.arrival << " arrivals, "
+                  << options.distribution << " tasks of mean " << options.mean_task_us << " us" << std::endl
+                  << std::setw(12) << "offered/s" << std::setw(12) << "achieved/s"
+                  << std::setw(10) << "wait p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+                  << std::setw(10) << "p999" << std::setw(12) << "max" << std::setw(12) << "sojourn p99"
+                  << std::endl;
+
+        auto queue = alias.make(options.threads);
+        for (auto rate: options.rates) {
+            run_rate(*queue, alias.name, options, rate, report);
+        }
+        std::cout << std::endl;
+    });
+
+    if (!options.output.empty()) {
+        return report.write_json(options.output, options.context()) ? 0 : 1;
+    }
+    return 0;
+}
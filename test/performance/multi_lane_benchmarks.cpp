@@ -0,0 +1,94 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <task_queues.hpp>
+#include "benchmark.h"
+
+// Multi-lane queue compared with the single lock fifo queue when many
+// external threads push.
+namespace {
+    using benchmark::clock_type;
+    using benchmark::to_ns;
+
+    template <class TaskQueue>
+    class producers_suite {
+        const benchmark::options &m_options;
+        benchmark::report &m_report;
+        const std::string m_subject;
+
+    public:
+        producers_suite(const benchmark::options &options, benchmark::report &report, std::string subject):
+                m_options(options),
+                m_report(report),
+                m_subject(std::move(subject)) {
+
+        }
+
+        // Tiny tasks pushed by `producers` threads at once, measured until
+        // all of them were run by `workers` threads.
+        void throughput(std::size_t producers, std::size_t workers) {
+            if (!m_options.enabled("producers/" + m_subject)) {
+                return;
+            }
+
+            const auto tasks_per_producer = m_options.tasks / producers;
+            auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                TaskQueue task_queue(workers);
+                std::atomic<std::size_t> executed{0u};
+                std::atomic_bool go{false};
+                std::vector<std::thread> threads;
+
+                for (auto i = 0u; i < producers; ++i) {
+                    threads.emplace_back([&task_queue, &executed, &go, tasks_per_producer] {
+                        while (!go.load()) {
+                            std::this_thread::yield();
+                        }
+                        for (auto j = 0u; j < tasks_per_producer; ++j) {
+                            task_queue.push([&executed] { executed.fetch_add(1u, std::memory_order_relaxed); });
+                        }
+                    });
+                }
+
+                const auto begin = clock_type::now();
+                go = true;
+                for (auto &thread: threads) {
+                    thread.join();
+                }
+                task_queue.wait_for_tasks_completion();
+                return to_ns(clock_type::now() - begin) / (tasks_per_producer * producers);
+            });
+            m_report.add(
+                    "producers",
+                    m_subject,
+                    {{"producers", producers}, {"workers", workers}},
+                    "ns/task",
+                    std::move(samples)
+            );
+        }
+
+        void run() {
+            const auto workers = m_options.max_threads;
+            for (std::size_t producers: {1u, 4u, 16u, 32u}) {
+                throughput(producers, workers);
+            }
+        }
+    };
+}
+
+// usage: thread_pool_multi_lane_benchmarks [--out file.json] [--filter producers/queue]
+//        [--max-threads N] [--tasks N] [--repetitions N] [--warmup N]
+int main(int argc, char **argv) {
+    const auto options = benchmark::options::parse(argc, argv);
+    benchmark::report report;
+
+    producers_suite<concurrent::n_threaded_fifo_task_queue>(options, report, "n_threaded_fifo").run();
+    producers_suite<concurrent::multi_lane_fifo_task_queue>(options, report, "multi_lane_fifo").run();
+    producers_suite<concurrent::multi_lane_task_queue<concurrent::thread_lane_selector>>(
+            options,
+            report,
+            "multi_lane_thread_lanes"
+    ).run();
+
+    return report.write_json(options.output, options.context()) ? 0 : 1;
+}
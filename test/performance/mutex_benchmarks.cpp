@@ -0,0 +1,156 @@
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <adaptive_mutex.hpp>
+#include <mcs_mutex.hpp>
+#include <ticket_mutex.hpp>
+#include <n_threaded_task_queue.hpp>
+#include <unsafe_fifo_queue.hpp>
+#include <semaphore.hpp>
+#include "benchmark.h"
+
+// Mutex policies compared on their own and as the queue mutex.
+namespace {
+    using benchmark::clock_type;
+    using benchmark::to_ns;
+
+    void spin(unsigned iterations) {
+        volatile unsigned counter = 0u;
+        for (auto i = 0u; i < iterations; ++i) {
+            counter = counter + 1u;
+        }
+    }
+
+    // Runs `function(thread_index)` in `threads` threads started at once,
+    // returns time from the start to the last one finishing.
+    template <class Function>
+    double run_concurrently(std::size_t threads, Function function) {
+        std::atomic<std::size_t> ready{0u};
+        std::atomic_bool go{false};
+        std::vector<std::thread> running;
+
+        for (auto i = 0u; i < threads; ++i) {
+            running.emplace_back([&, i] {
+                ++ready;
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                function(i);
+            });
+        }
+        while (ready.load() != threads) {
+            std::this_thread::yield();
+        }
+
+        const auto begin = clock_type::now();
+        go.store(true, std::memory_order_release);
+        for (auto &thread: running) {
+            thread.join();
+        }
+        return to_ns(clock_type::now() - begin);
+    }
+
+    template <class Mutex>
+    class mutex_suite {
+        const benchmark::options &m_options;
+        benchmark::report &m_report;
+        const std::string m_subject;
+
+    public:
+        mutex_suite(const benchmark::options &options, benchmark::report &report, std::string subject):
+                m_options(options),
+                m_report(report),
+                m_subject(std::move(subject)) {
+
+        }
+
+        // Threads repeatedly locking the mutex for `critical_section`
+        // iterations of work and doing `outside` iterations without it.
+        void lock_throughput(unsigned critical_section, unsigned outside) {
+            if (!m_options.enabled("lock_throughput/" + m_subject)) {
+                return;
+            }
+
+            for (auto threads: m_options.thread_counts()) {
+                const auto operations_per_thread = m_options.tasks / threads;
+                Mutex mutex;
+                std::size_t counter = 0u;
+
+                auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                    const auto elapsed = run_concurrently(threads, [&](std::size_t) {
+                        for (auto i = 0u; i < operations_per_thread; ++i) {
+                            {
+                                std::lock_guard<Mutex> lock(mutex);
+                                ++counter;
+                                spin(critical_section);
+                            }
+                            spin(outside);
+                        }
+                    });
+                    return elapsed / (operations_per_thread * threads);
+                });
+                m_report.add(
+                        "lock_throughput",
+                        m_subject,
+                        {{"threads", threads}, {"critical_section", critical_section}, {"outside", outside}},
+                        "ns/lock",
+                        std::move(samples)
+                );
+            }
+        }
+
+        // Empty tasks pushed by as many producers as there are workers.
+        void queue_throughput() {
+            if (!m_options.enabled("queue_throughput/" + m_subject)) {
+                return;
+            }
+
+            for (auto threads: m_options.thread_counts()) {
+                const auto tasks_per_producer = m_options.tasks / threads;
+                concurrent::n_threaded_task_queue<
+                        concurrent::unsafe_fifo_queue<std::function<void()>>,
+                        std::thread,
+                        concurrent::basic_semaphore<Mutex>,
+                        concurrent::no_instrumentation,
+                        Mutex
+                > queue(threads);
+
+                auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                    const auto begin = clock_type::now();
+                    run_concurrently(threads, [&](std::size_t) {
+                        for (auto i = 0u; i < tasks_per_producer; ++i) {
+                            queue.push([] {});
+                        }
+                    });
+                    queue.wait_for_tasks_completion();
+                    return to_ns(clock_type::now() - begin) / (tasks_per_producer * threads);
+                });
+                m_report.add("queue_throughput", m_subject, {{"threads", threads}}, "ns/task", std::move(samples));
+            }
+        }
+
+        void run() {
+            lock_throughput(0u, 0u);
+            lock_throughput(0u, 100u);
+            lock_throughput(100u, 100u);
+            queue_throughput();
+        }
+    };
+}
+
+// usage: thread_pool_mutex_benchmarks [--out file.json] [--filter scenario/mutex]
+//        [--max-threads N] [--tasks N] [--repetitions N] [--warmup N]
+int main(int argc, char **argv) {
+    const auto options = benchmark::options::parse(argc, argv);
+    benchmark::report report;
+
+    mutex_suite<std::mutex>(options, report, "std::mutex").run();
+    mutex_suite<concurrent::adaptive_mutex>(options, report, "adaptive_mutex").run();
+    mutex_suite<concurrent::ticket_mutex>(options, report, "ticket_mutex").run();
+    mutex_suite<concurrent::mcs_mutex>(options, report, "mcs_mutex").run();
+
+    return report.write_json(options.output, options.context()) ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <task_queues.hpp>
+#include <parallel_for_each.hpp>
+
+// Uniform access to every alias from task_queues.hpp for performance tools.
+namespace queue_aliases {
+    template <class TaskQueue>
+    using is_priority_queue = std::integral_constant<
+            bool,
+            !std::is_convertible<std::function<void()>, typename TaskQueue::pushed_value_type>::value
+    >;
+
+    // Tasks are pushed with the same priority to priority queues and with
+    // a deadline which never passes to deadline queues.
+    template <class Priority>
+    Priority same_priority(Priority *) {
+        return Priority();
+    }
+
+    template <class Clock, class Duration>
+    std::chrono::time_point<Clock, Duration> same_priority(std::chrono::time_point<Clock, Duration> *) {
+        return std::chrono::time_point<Clock, Duration>::max();
+    }
+
+    template <class TaskQueue>
+    auto same_priority() {
+        using priority_type = std::decay_t<typename TaskQueue::pushed_value_type::first_type>;
+        return same_priority(static_cast<priority_type *>(nullptr));
+    }
+
+    template <class TaskQueue, class F>
+    void push_task(TaskQueue &queue, F &&function, std::false_type) {
+        queue.push(std::function<void()>(std::forward<F>(function)));
+    }
+
+    template <class TaskQueue, class F>
+    void push_task(TaskQueue &queue, F &&function, std::true_type) {
+        queue.push(std::make_pair(same_priority<TaskQueue>(), std::function<void()>(std::forward<F>(function))));
+    }
+
+    template <class TaskQueue, class F>
+    void push_task(TaskQueue &queue, F &&function) {
+        push_task(queue, std::forward<F>(function), is_priority_queue<TaskQueue>());
+    }
+
+    template <class TaskQueue, class F>
+    auto push_task_with_result(TaskQueue &queue, F function, std::false_type) {
+        return queue.push_with_result(std::move(function));
+    }
+
+    template <class TaskQueue, class F>
+    auto push_task_with_result(TaskQueue &queue, F function, std::true_type) {
+        return queue.push_with_result(std::make_pair(same_priority<TaskQueue>(), std::move(function)));
+    }
+
+    template <class TaskQueue, class F>
+    auto push_task_with_result(TaskQueue &queue, F function) {
+        return push_task_with_result(queue, std::move(function), is_priority_queue<TaskQueue>());
+    }
+
+    template <class TaskQueue, class It, class F>
+    void for_each_task(TaskQueue &queue, It begin, It end, F operation, std::false_type) {
+        concurrent::parallel_for_each(queue, begin, end, operation);
+    }
+
+    // Priority and task are emplaced separately, queues with reserved
+    // workers and indexed ones take the priority as the first argument.
+    template <class TaskQueue, class It, class F>
+    void for_each_task(TaskQueue &queue, It begin, It end, F operation, std::true_type) {
+        for (; begin != end; ++begin) {
+            auto pointer = &*begin;
+            queue.emplace(same_priority<TaskQueue>(), std::function<void()>([pointer, operation] { operation(*pointer); }));
+        }
+        queue.wait_for_tasks_completion();
+    }
+
+    // Same alias with `Instrumentation` policy, void for queues which
+    // don't take one.
+    template <class TaskQueue, class Instrumentation>
+    struct instrumented {
+        using type = void;
+    };
+
+    template <
+            template <class> class Extension,
+            class Queue, class Thread, class Semaphore, class Replaced, class Mutex,
+            class Instrumentation
+    >
+    struct instrumented<
+            Extension<concurrent::n_threaded_task_queue<Queue, Thread, Semaphore, Replaced, Mutex>>,
+            Instrumentation
+    > {
+        using type = Extension<concurrent::n_threaded_task_queue<Queue, Thread, Semaphore, Instrumentation, Mutex>>;
+    };
+
+    template <
+            template <class> class Extension,
+            class Queue, class Thread, class Semaphore, class Duration, class Replaced, class Mutex,
+            class Instrumentation
+    >
+    struct instrumented<
+            Extension<concurrent::dynamic_task_queue<Queue, Thread, Semaphore, Duration, Replaced, Mutex>>,
+            Instrumentation
+    > {
+        using type = Extension<
+                concurrent::dynamic_task_queue<Queue, Thread, Semaphore, Duration, Instrumentation, Mutex>
+        >;
+    };
+
+    template <
+            template <class> class Extension,
+            class Queue, class Thread, class Semaphore, class Replaced, class Mutex,
+            class Instrumentation
+    >
+    struct instrumented<
+            Extension<concurrent::reserved_priority_task_queue<Queue, Thread, Semaphore, Replaced, Mutex>>,
+            Instrumentation
+    > {
+        using type = Extension<
+                concurrent::reserved_priority_task_queue<Queue, Thread, Semaphore, Instrumentation, Mutex>
+        >;
+    };
+
+    template <class TaskQueue, class Instrumentation>
+    using instrumented_t = typename instrumented<TaskQueue, Instrumentation>::type;
+
+    // Aliases can be rebound to another queue type, e.g. an instrumented one.
+    template <class TaskQueue>
+    struct n_threaded_alias {
+        using task_queue_type = TaskQueue;
+        template <class Other>
+        using rebind = n_threaded_alias<Other>;
+        const char *name;
+
+        std::unique_ptr<TaskQueue> make(std::size_t threads) const {
+            return std::unique_ptr<TaskQueue>(new TaskQueue(threads));
+        }
+    };
+
+    // Dynamic queues keep `threads` core workers and never grow beyond them,
+    // so they are compared with n-threaded ones at the same number of threads.
+    template <class TaskQueue>
+    struct dynamic_alias {
+        using task_queue_type = TaskQueue;
+        template <class Other>
+        using rebind = dynamic_alias<Other>;
+        const char *name;
+
+        std::unique_ptr<TaskQueue> make(std::size_t threads) const {
+            return std::unique_ptr<TaskQueue>(new TaskQueue(threads, threads));
+        }
+    };
+
+    // Late tasks of deadline queues are run, like tasks of other queues.
+    template <class TaskQueue>
+    struct n_threaded_deadline_alias {
+        using task_queue_type = TaskQueue;
+        template <class Other>
+        using rebind = n_threaded_deadline_alias<Other>;
+        const char *name;
+
+        std::unique_ptr<TaskQueue> make(std::size_t threads) const {
+            return std::unique_ptr<TaskQueue>(new TaskQueue(
+                    threads,
+                    typename TaskQueue::queue_type(concurrent::missed_deadline_policy::run)
+            ));
+        }
+    };
+
+    template <class TaskQueue>
+    struct dynamic_deadline_alias {
+        using task_queue_type = TaskQueue;
+        template <class Other>
+        using rebind = dynamic_deadline_alias<Other>;
+        const char *name;
+
+        std::unique_ptr<TaskQueue> make(std::size_t threads) const {
+            return std::unique_ptr<TaskQueue>(new TaskQueue(
+                    threads,
+                    threads,
+                    std::chrono::milliseconds(100),
+                    1u,
+                    typename TaskQueue::queue_type(concurrent::missed_deadline_policy::run)
+            ));
+        }
+    };
+
+    // One of `threads` workers is reserved, tasks of the same priority
+    // reach the threshold, so all of them run tasks.
+    template <class TaskQueue>
+    struct reserved_alias {
+        using task_queue_type = TaskQueue;
+        template <class Other>
+        using rebind = reserved_alias<Other>;
+        const char *name;
+
+        std::unique_ptr<TaskQueue> make(std::size_t threads) const {
+            return std::unique_ptr<TaskQueue>(new TaskQueue(threads, 1u, same_priority<TaskQueue>()));
+        }
+    };
+
+    template <class Visitor>
+    void for_each(Visitor &&visitor) {
+        visitor(n_threaded_alias<concurrent::n_threaded_fifo_task_queue>{"n_threaded_fifo_task_queue"});
+        visitor(n_threaded_alias<concurrent::n_threaded_lifo_task_queue>{"n_threaded_lifo_task_queue"});
+        visitor(n_threaded_alias<concurrent::n_threaded_priority_task_queue>{"n_threaded_priority_task_queue"});
+        visitor(dynamic_alias<concurrent::dynamic_fifo_task_queue>{"dynamic_fifo_task_queue"});
+        visitor(dynamic_alias<concurrent::dynamic_lifo_task_queue>{"dynamic_lifo_task_queue"});
+        visitor(dynamic_alias<concurrent::dynamic_priority_task_queue>{"dynamic_priority_task_queue"});
+        visitor(n_threaded_alias<concurrent::n_threaded_indexed_priority_task_queue>{
+                "n_threaded_indexed_priority_task_queue"
+        });
+        visitor(dynamic_alias<concurrent::dynamic_indexed_priority_task_queue>{"dynamic_indexed_priority_task_queue"});
+        visitor(n_threaded_deadline_alias<concurrent::n_threaded_deadline_task_queue>{"n_threaded_deadline_task_queue"});
+        visitor(dynamic_deadline_alias<concurrent::dynamic_deadline_task_queue>{"dynamic_deadline_task_queue"});
+        visitor(reserved_alias<concurrent::n_threaded_reserved_priority_task_queue>{
+                "n_threaded_reserved_priority_task_queue"
+        });
+        visitor(n_threaded_alias<concurrent::multi_lane_fifo_task_queue>{"multi_lane_fifo_task_queue"});
+    }
+}
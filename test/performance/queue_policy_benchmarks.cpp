@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unsafe_fifo_queue.hpp>
+#include <unsafe_lifo_queue.hpp>
+#include <unsafe_priority_queue.hpp>
+#include "benchmark.h"
+
+// Queue policies measured on their own, without locks and workers, to
+// compare containers they could be built on.
+namespace {
+    using benchmark::clock_type;
+    using benchmark::to_ns;
+
+    // Single-threaded, policies are unsafe anyway.
+    struct allocation_counter {
+        static std::size_t &live_bytes() {
+            static std::size_t bytes = 0u;
+            return bytes;
+        }
+    };
+
+    template <class T>
+    struct counting_allocator {
+        using value_type = T;
+
+        counting_allocator() noexcept = default;
+
+        template <class U>
+        counting_allocator(const counting_allocator<U> &) noexcept {
+        }
+
+        T *allocate(std::size_t count) {
+            allocation_counter::live_bytes() += count * sizeof(T);
+            return std::allocator<T>().allocate(count);
+        }
+
+        void deallocate(T *pointer, std::size_t count) noexcept {
+            allocation_counter::live_bytes() -= count * sizeof(T);
+            std::allocator<T>().deallocate(pointer, count);
+        }
+
+        template <class U>
+        bool operator==(const counting_allocator<U> &) const noexcept {
+            return true;
+        }
+
+        template <class U>
+        bool operator!=(const counting_allocator<U> &) const noexcept {
+            return false;
+        }
+    };
+
+    // Elements are pushed the same way task queues push them.
+    struct fifo_policy {
+        template <class T>
+        using queue_type = concurrent::unsafe_fifo_queue<T, std::deque<T, counting_allocator<T>>>;
+
+        static const char *name() {
+            return "unsafe_fifo_queue";
+        }
+
+        template <class Queue, class T>
+        static void push(Queue &queue, T &&value, int) {
+            queue.push(std::forward<T>(value));
+        }
+    };
+
+    struct lifo_policy {
+        template <class T>
+        using queue_type = concurrent::unsafe_lifo_queue<T, std::vector<T, counting_allocator<T>>>;
+
+        static const char *name() {
+            return "unsafe_lifo_queue";
+        }
+
+        template <class Queue, class T>
+        static void push(Queue &queue, T &&value, int) {
+            queue.push(std::forward<T>(value));
+        }
+    };
+
+    struct priority_policy {
+        template <class T>
+        using queue_type = concurrent::unsafe_priority_queue<
+                int,
+                T,
+                std::multimap<int, T, std::greater<int>, counting_allocator<std::pair<const int, T>>>
+        >;
+
+        static const char *name() {
+            return "unsafe_priority_queue";
+        }
+
+        template <class Queue, class T>
+        static void push(Queue &queue, T &&value, int rank) {
+            queue.push(std::make_pair(rank, std::forward<T>(value)));
+        }
+    };
+
+    using large_array = std::array<char, 256u>;
+
+    struct int_payload {
+        using type = int;
+
+        static const char *name() {
+            return "int";
+        }
+
+        static type make(int value) {
+            return value;
+        }
+    };
+
+    struct task_payload {
+        using type = std::function<void()>;
+
+        static const char *name() {
+            return "std::function";
+        }
+
+        static type make(int value) {
+            return [value] { static_cast<void>(value); };
+        }
+    };
+
+    // Expensive to move.
+    struct array_payload {
+        using type = large_array;
+
+        static const char *name() {
+            return "array<char, 256>";
+        }
+
+        static type make(int value) {
+            type result;
+            result.fill(static_cast<char>(value));
+            return result;
+        }
+    };
+
+    // Large, but cheap to move.
+    struct vector_payload {
+        using type = std::vector<char>;
+
+        static const char *name() {
+            return "vector<char>(1024)";
+        }
+
+        static type make(int value) {
+            return type(1024u, static_cast<char>(value));
+        }
+    };
+
+    std::vector<int> random_ranks(std::size_t count) {
+        std::mt19937 random(13u);
+        std::vector<int> ranks(count);
+        for (auto &rank: ranks) {
+            rank = static_cast<int>(random() % 8u);
+        }
+        return ranks;
+    }
+
+    template <class Policy, class Payload>
+    class policy_suite {
+        using value_type = typename Payload::type;
+        using queue_type = typename Policy::template queue_type<value_type>;
+
+        const benchmark::options &m_options;
+        benchmark::report &m_report;
+        const std::string m_subject;
+        const std::vector<int> m_ranks;
+
+        void add(const std::string &name, benchmark::parameters_type parameters,
+                 const std::string &unit, std::vector<double> samples) {
+            m_report.add(name, m_subject, std::move(parameters), unit, std::move(samples));
+        }
+
+        std::vector<value_type> make_values(std::size_t count) const {
+            std::vector<value_type> values;
+            values.reserve(count);
+            for (auto i = 0u; i < count; ++i) {
+                values.push_back(Payload::make(static_cast<int>(i)));
+            }
+            return values;
+        }
+
+        int rank(std::size_t index) const {
+            return m_ranks[index % m_ranks.size()];
+        }
+
+    public:
+        policy_suite(const benchmark::options &options, benchmark::report &report):
+                m_options(options),
+                m_report(report),
+                m_subject(std::string(Policy::name()) + "<" + Payload::name() + ">"),
+                m_ranks(random_ranks(4096u)) {
+
+        }
+
+        // Push of popped element to the queue of constant length.
+        void steady_state() {
+            if (!m_options.enabled("steady_state/" + m_subject)) {
+                return;
+            }
+
+            constexpr std::size_t length = 1024u;
+            const auto operations = m_options.tasks;
+            queue_type queue;
+            auto values = make_values(length);
+            for (auto i = 0u; i < length; ++i) {
+                Policy::push(queue, std::move(values[i]), rank(i));
+            }
+
+            auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                const auto begin = clock_type::now();
+                for (auto i = 0u; i < operations; ++i) {
+                    Policy::push(queue, queue.pop(), rank(i));
+                }
+                return to_ns(clock_type::now() - begin) / (2u * operations);
+            });
+            add("steady_state", {{"length", length}}, "ns/op", std::move(samples));
+        }
+
+        // Random pushes and pops, `push_percent` of operations are pushes.
+        void push_pop_mix(unsigned push_percent) {
+            if (!m_options.enabled("push_pop_mix/" + m_subject)) {
+                return;
+            }
+
+            const auto operations = m_options.tasks;
+            std::mt19937 random(push_percent);
+            std::vector<bool> is_push(operations);
+            for (auto i = 0u; i < operations; ++i) {
+                is_push[i] = random() % 100u < push_percent;
+            }
+            const auto pushes = static_cast<std::size_t>(std::count(is_push.begin(), is_push.end(), true));
+
+            auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                queue_type queue;
+                auto values = make_values(pushes);
+                std::size_t pushed = 0u;
+
+                const auto begin = clock_type::now();
+                for (auto i = 0u; i < operations; ++i) {
+                    if (is_push[i]) {
+                        Policy::push(queue, std::move(values[pushed]), rank(pushed));
+                        ++pushed;
+                    } else if (!queue.empty()) {
+                        auto value = queue.pop();
+                        static_cast<void>(value);
+                    }
+                }
+                return to_ns(clock_type::now() - begin) / operations;
+            });
+            add("push_pop_mix", {{"push_percent", push_percent}}, "ns/op", std::move(samples));
+        }
+
+        // Filling the queue with `burst` elements and draining it.
+        void fill_drain(std::size_t burst) {
+            if (!m_options.enabled("fill_drain/" + m_subject)) {
+                return;
+            }
+
+            const auto rounds = std::max<std::size_t>(1u, m_options.tasks / burst);
+            auto samples = benchmark::repeat(m_options.warmup, m_options.repetitions, [&] {
+                queue_type queue;
+                double elapsed = 0.0;
+
+                for (auto round = 0u; round < rounds; ++round) {
+                    auto values = make_values(burst);
+
+                    const auto begin = clock_type::now();
+                    for (auto i = 0u; i < burst; ++i) {
+                        Policy::push(queue, std::move(values[i]), rank(i));
+                    }
+                    while (!queue.empty()) {
+                        auto value = queue.pop();
+                        static_cast<void>(value);
+                    }
+                    elapsed += to_ns(clock_type::now() - begin);
+                }
+                return elapsed / (2u * rounds * burst);
+            });
+            add("fill_drain", {{"burst", burst}}, "ns/op", std::move(samples));
+        }
+
+        // Bytes allocated by container per element, payload's own heap
+        // memory isn't counted.
+        void memory(std::size_t length) {
+            if (!m_options.enabled("memory/" + m_subject)) {
+                return;
+            }
+
+            auto samples = benchmark::repeat(0u, 1u, [&] {
+                const auto before = allocation_counter::live_bytes();
+                queue_type queue;
+                auto values = make_values(length);
+                for (auto i = 0u; i < length; ++i) {
+                    Policy::push(queue, std::move(values[i]), rank(i));
+                }
+                return static_cast<double>(allocation_counter::live_bytes() - before) / length;
+            });
+            add("memory", {{"length", length}, {"sizeof", sizeof(value_type)}}, "bytes/element", std::move(samples));
+        }
+
+        void run() {
+            steady_state();
+            push_pop_mix(50u);
+            push_pop_mix(70u);
+            for (std::size_t burst: {16u, 1024u, 65536u}) {
+                fill_drain(burst);
+            }
+            for (std::size_t length: {1024u, 65536u}) {
+                memory(length);
+            }
+        }
+    };
+
+    template <class Policy>
+    void run_policy(const benchmark::options &options, benchmark::report &report) {
+        policy_suite<Policy, int_payload>(options, report).run();
+        policy_suite<Policy, task_payload>(options, report).run();
+        policy_suite<Policy, array_payload>(options, report).run();
+        policy_suite<Policy, vector_payload>(options, report).run();
+    }
+}
+
+// usage: thread_pool_queue_policy_benchmarks [--out file.json] [--filter scenario/policy<payload>]
+//        [--tasks N] [--repetitions N] [--warmup N]
+int main(int argc, char **argv) {
+    const auto options = benchmark::options::parse(argc, argv);
+    benchmark::report report;
+
+    run_policy<fifo_policy>(options, report);
+    run_policy<lifo_policy>(options, report);
+    run_policy<priority_policy>(options, report);
+
+    return report.write_json(options.output, options.context()) ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+#include <catch.hpp>
+#include <barrier.hpp>
+#include <tree_barrier.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+namespace {
+    // Every thread writes its phase number to its own slot before waiting,
+    // after the barrier all slots have to hold the same phase. Returns
+    // false if some thread saw a slot from another phase.
+    template <class Wait>
+    bool phases_stay_in_lockstep(std::size_t threads_count, std::size_t phases, Wait wait) {
+        std::vector<std::size_t> slots(threads_count, 0u);
+        std::atomic_bool in_lockstep{true};
+        std::vector<std::thread> threads;
+
+        for (auto i = 0u; i < threads_count; ++i) {
+            threads.emplace_back([&, i] {
+                for (auto phase = 1u; phase <= phases; ++phase) {
+                    slots[i] = phase;
+                    wait(i);
+                    for (auto slot: slots) {
+                        if (slot < phase) {
+                            in_lockstep = false;
+                        }
+                    }
+                    wait(i);
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+
+        return in_lockstep;
+    }
+}
+
+SCENARIO("reusing barrier", "[concurrent::barrier]") {
+    GIVEN("a barrier for 4 threads") {
+        std::size_t completions = 0u;
+        concurrent::barrier barrier(4, [&completions] { ++completions; });
+
+        WHEN("4 threads pass it 100 times") {
+            const auto in_lockstep = phases_stay_in_lockstep(4u, 50u, [&barrier](std::size_t) {
+                barrier.wait();
+            });
+
+            THEN("no thread leaves a phase before all of them arrive") {
+                REQUIRE(in_lockstep);
+            }
+
+            THEN("completion function is called once per phase") {
+                REQUIRE(completions == 100u);
+            }
+        }
+
+        WHEN("one of threads drops out after the first phase") {
+            std::vector<std::thread> threads;
+            threads.emplace_back([&barrier] { barrier.arrive_and_drop(); });
+            for (int i = 0; i < 3; ++i) {
+                threads.emplace_back([&barrier] {
+                    for (int phase = 0; phase < 10; ++phase) {
+                        barrier.wait();
+                    }
+                });
+            }
+            for (auto &thread: threads) {
+                thread.join();
+            }
+
+            THEN("remaining threads pass following phases without it") {
+                REQUIRE(completions == 10u);
+            }
+        }
+
+        WHEN("only one thread waits") {
+            THEN("waiting times out") {
+                REQUIRE_FALSE(barrier.wait_for(10ms));
+                REQUIRE(completions == 0u);
+
+                AND_WHEN("remaining threads arrive") {
+                    std::vector<std::thread> threads;
+                    for (int i = 0; i < 3; ++i) {
+                        threads.emplace_back([&barrier] { barrier.wait(); });
+                    }
+                    for (auto &thread: threads) {
+                        thread.join();
+                    }
+
+                    THEN("the thread which timed out is counted in the phase") {
+                        REQUIRE(completions == 1u);
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a barrier for 1 thread") {
+        concurrent::barrier barrier(1);
+
+        WHEN("the thread drops out twice") {
+            barrier.arrive_and_drop();
+            barrier.arrive_and_drop();
+
+            THEN("waiting doesn't block") {
+                REQUIRE(barrier.wait_for(10ms));
+            }
+        }
+    }
+
+    GIVEN("a copy of an unused barrier for 2 threads") {
+        const concurrent::barrier original(2);
+        concurrent::barrier barrier(original);
+
+        WHEN("2 threads wait for it") {
+            std::thread second([&barrier] { barrier.wait(); });
+
+            THEN("both are released") {
+                REQUIRE(barrier.wait_for(config::default_timeout));
+                second.join();
+            }
+        }
+    }
+}
+
+SCENARIO("combining arrivals in tree barrier", "[concurrent::tree_barrier]") {
+    GIVEN("a tree barrier for 11 threads with 3 children per node") {
+        std::size_t completions = 0u;
+        concurrent::tree_barrier barrier(11, [&completions] { ++completions; }, 3);
+
+        WHEN("11 threads pass it 100 times") {
+            const auto in_lockstep = phases_stay_in_lockstep(11u, 50u, [&barrier](std::size_t participant) {
+                barrier.wait(participant);
+            });
+
+            THEN("no thread leaves a phase before all of them arrive") {
+                REQUIRE(in_lockstep);
+            }
+
+            THEN("completion function is called once per phase") {
+                REQUIRE(completions == 100u);
+            }
+        }
+
+        WHEN("only some threads arrive") {
+            std::vector<std::thread> threads;
+            for (auto i = 0u; i < 9u; ++i) {
+                threads.emplace_back([&barrier, i] { barrier.wait(i); });
+            }
+
+            THEN("the phase doesn't complete") {
+                REQUIRE_FALSE(barrier.wait_for(9u, 10ms));
+                REQUIRE(completions == 0u);
+
+                AND_WHEN("the last thread arrives") {
+                    REQUIRE(barrier.wait_for(10u, config::default_timeout));
+
+                    THEN("all threads are released") {
+                        for (auto &thread: threads) {
+                            thread.join();
+                        }
+                        REQUIRE(completions == 1u);
+                    }
+                }
+            }
+
+            if (completions == 0u) {
+                barrier.wait(10u);
+            }
+            for (auto &thread: threads) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+    }
+
+    GIVEN("a tree barrier for a single thread") {
+        concurrent::tree_barrier barrier(1);
+
+        THEN("waiting never blocks") {
+            REQUIRE(barrier.wait_for(0u, config::default_timeout));
+            REQUIRE(barrier.wait_for(0u, config::default_timeout));
+        }
+    }
+
+    GIVEN("a tree barrier for no threads") {
+        std::size_t completions = 0u;
+        concurrent::tree_barrier barrier(0, [&completions] { ++completions; });
+
+        THEN("waiting doesn't block") {
+            barrier.wait(0u);
+            REQUIRE(barrier.wait_for(0u, config::default_timeout));
+            REQUIRE(barrier.size() == 0u);
+            REQUIRE(completions == 0u);
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include <catch.hpp>
+#include <blocking_section.hpp>
+#include <task_queues.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "test_configuration.h"
+
+namespace {
+    // Handler which fails to start a compensating worker.
+    class failing_blocking_handler: public concurrent::blocking_handler {
+    public:
+        int blocked{0};
+
+        void begin_blocking() override {
+            ++blocked;
+            throw std::runtime_error("no thread");
+        }
+
+        void end_blocking() override {
+            --blocked;
+        }
+    };
+}
+
+SCENARIO("compensating for workers blocked in tasks", "[concurrent::blocking_section]") {
+    GIVEN("a 1-threaded fifo task queue") {
+        concurrent::n_threaded_fifo_task_queue task_queue(1u);
+
+        WHEN("a task blocks in a blocking section") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            concurrent::latch done(1u);
+            std::atomic_bool released{false};
+
+            task_queue.push([&started, &release, &released] {
+                concurrent::blocking_section blocking;
+                started.count_down();
+                released = release.wait_for(config::default_timeout);
+            });
+            started.wait();
+            task_queue.push([&done] { done.count_down(); });
+
+            THEN("other tasks are run by a compensating worker") {
+                const auto finished = done.wait_for(config::default_timeout);
+                release.count_down();
+                task_queue.wait_for_tasks_completion();
+
+                REQUIRE(finished);
+                REQUIRE(released);
+            }
+        }
+
+        WHEN("tasks block in sections one after another") {
+            std::atomic<int> executed{0};
+
+            for (int i = 0; i < 20; ++i) {
+                task_queue.push([&executed] {
+                    concurrent::blocking_section blocking;
+                    ++executed;
+                });
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("all of them are run") {
+                REQUIRE(executed == 20);
+            }
+        }
+
+        WHEN("tasks are pushed while a blocking section ends") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            std::atomic_bool ended{false};
+            std::atomic<int> executed_after_end{0};
+            std::mutex threads_mutex;
+            std::set<std::thread::id> threads;
+
+            task_queue.push([&started, &release, &ended] {
+                {
+                    concurrent::blocking_section blocking;
+                    started.count_down();
+                    release.wait_for(config::default_timeout);
+                }
+                ended = true;
+            });
+            started.wait();
+            // tasks are pushed faster than they're run, so the queue isn't
+            // empty, the first ones after the end might have been taken by
+            // the compensating worker before it
+            const auto task = [&ended, &executed_after_end, &threads_mutex, &threads] {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                if (ended && ++executed_after_end > 20) {
+                    std::lock_guard<std::mutex> lock(threads_mutex);
+                    threads.insert(std::this_thread::get_id());
+                }
+            };
+            for (int i = 0; i < 100; ++i) {
+                task_queue.push(task);
+            }
+            release.count_down();
+            for (int i = 0; i < 200; ++i) {
+                task_queue.push(task);
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("the compensating worker exits after its current task") {
+                REQUIRE(threads.size() == 1u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded reserved priority task queue with 1 reserved worker") {
+        concurrent::n_threaded_reserved_priority_task_queue task_queue(2u, 1u, 10);
+
+        WHEN("waiting for completion of a task in a blocking section") {
+            concurrent::latch started(1u);
+            std::atomic_bool finished{false};
+
+            task_queue.push(std::make_pair(0, std::function<void()>([&started, &finished] {
+                concurrent::blocking_section blocking;
+                started.count_down();
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                finished = true;
+            })));
+            started.wait();
+            task_queue.wait_for_tasks_completion();
+
+            THEN("it returns after the task is finished") {
+                REQUIRE(finished);
+            }
+        }
+    }
+
+    GIVEN("a handler which fails to start a compensating worker") {
+        failing_blocking_handler handler;
+        concurrent::current_blocking_handler() = &handler;
+
+        WHEN("a blocking section is entered and left") {
+            {
+                concurrent::blocking_section blocking;
+                REQUIRE(handler.blocked == 1);
+            }
+            concurrent::current_blocking_handler() = nullptr;
+
+            THEN("the task blocks without it and the handler is told it ended") {
+                REQUIRE(handler.blocked == 0);
+            }
+        }
+    }
+
+    GIVEN("a thread which isn't a worker") {
+        THEN("a blocking section does nothing") {
+            REQUIRE(concurrent::current_blocking_handler() == nullptr);
+            concurrent::blocking_section blocking;
+        }
+    }
+}
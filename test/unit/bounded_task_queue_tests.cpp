@@ -0,0 +1,179 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+namespace {
+    // One worker is kept busy, so pushed tasks stay in the queue.
+    template <class TaskQueue>
+    void require_backpressure(TaskQueue &task_queue) {
+        concurrent::latch started(1u);
+        concurrent::latch release(1u);
+        std::atomic<int> executed{0};
+
+        task_queue.push([&started, &release] {
+            started.count_down();
+            release.wait();
+        });
+        started.wait();
+
+        REQUIRE(task_queue.capacity() == 2u);
+        REQUIRE(task_queue.try_push([&executed] { ++executed; }));
+        task_queue.push([&executed] { ++executed; });
+
+        std::function<void(void)> rejected = [&executed] { ++executed; };
+        REQUIRE_FALSE(task_queue.try_push(std::move(rejected)));
+        REQUIRE(rejected != nullptr);
+        REQUIRE_FALSE(task_queue.try_push_for([&executed] { ++executed; }, 1ms));
+
+        std::atomic_bool pushed{false};
+        std::thread producer([&task_queue, &executed, &pushed] {
+            task_queue.push([&executed] { ++executed; });
+            pushed = true;
+        });
+        std::this_thread::sleep_for(1ms);
+        REQUIRE_FALSE(pushed);
+
+        release.count_down();
+        producer.join();
+        REQUIRE(task_queue.try_push_for([&executed] { ++executed; }, config::default_timeout));
+        task_queue.wait_for_tasks_completion();
+
+        REQUIRE(executed == 4);
+        REQUIRE(task_queue.size() == 0u);
+    }
+
+    // Pushing thread holds the queue mutex, like a worker taking a task.
+    template <class TaskQueue>
+    void require_non_blocking_push(TaskQueue &task_queue) {
+        using staging_lane = typename TaskQueue::staging_lane;
+        auto &queue_mutex = const_cast<typename TaskQueue::mutex_type &>(task_queue.queue_mutex());
+        std::mutex order_mutex;
+        std::vector<int> order;
+        auto task = [&order_mutex, &order](int i) {
+            return [&order_mutex, &order, i] {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(i);
+            };
+        };
+        staging_lane lane(2u);
+
+        std::unique_lock<typename TaskQueue::mutex_type> lock(queue_mutex);
+        std::thread producer([&] {
+            REQUIRE_FALSE(task_queue.try_push(task(0)));
+            REQUIRE(task_queue.try_push(lane, task(1)));
+            REQUIRE(task_queue.try_push(lane, task(2)));
+            REQUIRE_FALSE(task_queue.try_push(lane, task(3)));
+        });
+        producer.join();
+        lock.unlock();
+
+        REQUIRE(task_queue.size() == 0u);
+        REQUIRE(task_queue.try_push(lane, task(4)));
+        task_queue.flush(lane);
+        task_queue.wait_for_tasks_completion();
+        REQUIRE(order == std::vector<int>({1, 2, 4}));
+
+        lock.lock();
+        std::thread staging([&] { REQUIRE(task_queue.try_push(lane, task(5))); });
+        staging.join();
+        lock.unlock();
+        task_queue.flush(lane);
+        task_queue.wait_for_tasks_completion();
+        REQUIRE(order == std::vector<int>({1, 2, 4, 5}));
+    }
+
+    // Tasks staged in a registered lane are run without being flushed.
+    template <class TaskQueue>
+    void require_registered_lane_drained(TaskQueue &task_queue) {
+        using staging_lane = typename TaskQueue::staging_lane;
+        auto &queue_mutex = const_cast<typename TaskQueue::mutex_type &>(task_queue.queue_mutex());
+        concurrent::latch executed(2u);
+        staging_lane lane(2u);
+        task_queue.register_lane(lane);
+
+        std::unique_lock<typename TaskQueue::mutex_type> lock(queue_mutex);
+        std::thread producer([&] {
+            REQUIRE(task_queue.try_push(lane, [&executed] { executed.count_down(); }));
+            REQUIRE(task_queue.try_push(lane, [&executed] { executed.count_down(); }));
+        });
+        producer.join();
+        lock.unlock();
+
+        REQUIRE(executed.wait_for(config::default_timeout));
+        task_queue.unregister_lane(lane);
+    }
+}
+
+SCENARIO("pushing to n-threaded queue with limited capacity", "[concurrent::n_threaded_task_queue]") {
+    GIVEN("a single threaded fifo queue for 2 tasks") {
+        concurrent::n_threaded_fifo_task_queue task_queue(
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::eager,
+                2u
+        );
+
+        THEN("pushing blocks or fails until the worker makes room") {
+            require_backpressure(task_queue);
+        }
+    }
+
+    GIVEN("a queue with default capacity") {
+        concurrent::n_threaded_fifo_task_queue task_queue(1u);
+
+        THEN("it's unbounded") {
+            REQUIRE(task_queue.capacity() == concurrent::unbounded_capacity);
+            REQUIRE(task_queue.try_push_for([] {}, config::default_timeout));
+        }
+    }
+}
+
+SCENARIO("pushing to dynamic queue with limited capacity", "[concurrent::dynamic_task_queue]") {
+    GIVEN("a dynamic queue with 1 worker for 2 tasks") {
+        concurrent::dynamic_fifo_task_queue task_queue(
+                1u,
+                1u,
+                std::chrono::milliseconds(100),
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                0u,
+                std::chrono::milliseconds::zero(),
+                2u
+        );
+
+        THEN("pushing blocks or fails until the worker makes room") {
+            require_backpressure(task_queue);
+        }
+    }
+}
+
+SCENARIO("pushing to task queues without blocking", "[concurrent::n_threaded_task_queue][concurrent::dynamic_task_queue]") {
+    GIVEN("a single threaded fifo queue") {
+        concurrent::n_threaded_fifo_task_queue task_queue(1u);
+
+        THEN("non-blocking push fails or stages tasks while the queue is locked") {
+            require_non_blocking_push(task_queue);
+        }
+
+        THEN("workers run tasks staged in a registered lane") {
+            require_registered_lane_drained(task_queue);
+        }
+    }
+
+    GIVEN("a dynamic queue with 1 worker") {
+        concurrent::dynamic_fifo_task_queue task_queue(1u, 1u);
+
+        THEN("non-blocking push fails or stages tasks while the queue is locked") {
+            require_non_blocking_push(task_queue);
+        }
+
+        THEN("workers run tasks staged in a registered lane") {
+            require_registered_lane_drained(task_queue);
+        }
+    }
+}
@@ -0,0 +1,220 @@
+#include <catch.hpp>
+#include <channel.hpp>
+#include <lightweight_semaphore.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+namespace {
+    template <class Channel>
+    void require_fifo_order_and_capacity() {
+        Channel channel(4);
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(channel.try_send(i));
+        }
+        REQUIRE_FALSE(channel.try_send(4));
+        REQUIRE_FALSE(channel.try_send_for(4, 1ms));
+
+        int value = -1;
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(channel.try_recv(value));
+            REQUIRE(value == i);
+        }
+        REQUIRE_FALSE(channel.try_recv(value));
+        REQUIRE_FALSE(channel.try_recv_for(value, 1ms));
+    }
+
+    template <class Channel>
+    void require_move_only_values_support() {
+        Channel channel(2);
+        auto sent = std::make_unique<int>(7);
+
+        REQUIRE(channel.send(std::move(sent)));
+        REQUIRE(sent == nullptr);
+
+        auto kept = std::make_unique<int>(8);
+        REQUIRE(channel.try_send(std::move(kept)));
+        auto rejected = std::make_unique<int>(9);
+        REQUIRE_FALSE(channel.try_send(std::move(rejected)));
+        REQUIRE(rejected != nullptr);
+
+        std::unique_ptr<int> received;
+        REQUIRE(channel.recv(received));
+        REQUIRE(*received == 7);
+    }
+
+    template <class Channel>
+    void require_close_semantics() {
+        Channel channel(4);
+        REQUIRE(channel.send(1));
+        REQUIRE(channel.send(2));
+
+        channel.close();
+
+        REQUIRE(channel.closed());
+        REQUIRE_FALSE(channel.send(3));
+        REQUIRE_FALSE(channel.try_send(3));
+
+        int value = 0;
+        REQUIRE(channel.recv(value));
+        REQUIRE(value == 1);
+        REQUIRE(channel.try_recv(value));
+        REQUIRE(value == 2);
+        REQUIRE_FALSE(channel.recv(value));
+        REQUIRE_FALSE(channel.try_recv_for(value, config::default_timeout));
+    }
+
+    template <class Channel>
+    void require_close_wakes_blocked_receiver() {
+        Channel channel(4);
+        std::atomic_bool received{true};
+
+        std::thread receiver([&channel, &received] {
+            int value = 0;
+            received = channel.recv(value);
+        });
+        std::this_thread::sleep_for(1ms);
+        channel.close();
+        receiver.join();
+
+        REQUIRE_FALSE(received);
+    }
+
+    template <class Channel>
+    void require_close_wakes_blocked_sender() {
+        Channel channel(1);
+        REQUIRE(channel.send(1));
+        std::atomic_bool sent{true};
+
+        std::thread sender([&channel, &sent] { sent = channel.send(2); });
+        std::this_thread::sleep_for(1ms);
+        channel.close();
+        sender.join();
+
+        REQUIRE_FALSE(sent);
+    }
+
+    template <class Channel>
+    void require_batch_receive() {
+        Channel channel(8);
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(channel.send(i));
+        }
+
+        std::vector<int> received;
+        REQUIRE(channel.recv_batch(std::back_inserter(received), 3u) == 3u);
+        REQUIRE(channel.try_recv_batch(std::back_inserter(received), 8u) == 2u);
+        REQUIRE(channel.try_recv_batch(std::back_inserter(received), 8u) == 0u);
+        REQUIRE(received == std::vector<int>({0, 1, 2, 3, 4}));
+
+        channel.close();
+        REQUIRE(channel.recv_batch(std::back_inserter(received), 8u) == 0u);
+    }
+
+    // Every value sent by `producers` threads is received exactly once by
+    // `consumers` threads through a channel much smaller than their count.
+    template <class Channel>
+    void require_values_pass_through(std::size_t producers, std::size_t consumers) {
+        constexpr int values_per_producer = 10000;
+        Channel channel(16);
+        std::vector<std::vector<int>> received(consumers);
+        std::vector<std::thread> threads;
+
+        for (auto i = 0u; i < consumers; ++i) {
+            threads.emplace_back([&channel, &received, i] {
+                int value = 0;
+                while (channel.recv(value)) {
+                    received[i].push_back(value);
+                }
+            });
+        }
+
+        std::vector<std::thread> sending;
+        for (auto i = 0u; i < producers; ++i) {
+            sending.emplace_back([&channel, i] {
+                for (int j = 0; j < values_per_producer; ++j) {
+                    channel.send(static_cast<int>(i) * values_per_producer + j);
+                }
+            });
+        }
+        for (auto &thread: sending) {
+            thread.join();
+        }
+        channel.close();
+        for (auto &thread: threads) {
+            thread.join();
+        }
+
+        std::vector<int> all;
+        for (const auto &values: received) {
+            // single producer is received in order by every consumer
+            if (producers == 1u) {
+                REQUIRE(std::is_sorted(values.begin(), values.end()));
+            }
+            all.insert(all.end(), values.begin(), values.end());
+        }
+        std::sort(all.begin(), all.end());
+        std::vector<int> expected(producers * values_per_producer);
+        std::iota(expected.begin(), expected.end(), 0);
+
+        REQUIRE(all == expected);
+    }
+
+    template <class Channel>
+    void require_channel() {
+        require_fifo_order_and_capacity<Channel>();
+        require_close_semantics<Channel>();
+        require_close_wakes_blocked_receiver<Channel>();
+        require_close_wakes_blocked_sender<Channel>();
+        require_batch_receive<Channel>();
+    }
+}
+
+TEST_CASE("mpmc channel", "[concurrent::channel]") {
+    require_channel<concurrent::channel<int>>();
+    require_move_only_values_support<concurrent::channel<std::unique_ptr<int>>>();
+    require_values_pass_through<concurrent::channel<int>>(4u, 4u);
+    require_values_pass_through<concurrent::channel<int>>(1u, 3u);
+}
+
+TEST_CASE("spsc channel", "[concurrent::spsc_channel]") {
+    require_channel<concurrent::spsc_channel<int>>();
+    require_move_only_values_support<concurrent::spsc_channel<std::unique_ptr<int>>>();
+    require_values_pass_through<concurrent::spsc_channel<int>>(1u, 1u);
+}
+
+SCENARIO("lightweight semaphore", "[concurrent::lightweight_semaphore]") {
+    GIVEN("a lightweight semaphore with 2 permits") {
+        concurrent::lightweight_semaphore<> semaphore(2);
+
+        THEN("permits are acquired without waiting") {
+            REQUIRE(semaphore.try_acquire(2u));
+            REQUIRE_FALSE(semaphore.try_acquire());
+            REQUIRE(semaphore.try_acquire_up_to(4u) == 0u);
+        }
+
+        WHEN("more permits are acquired than available") {
+            THEN("acquiring times out and gives permits back") {
+                REQUIRE_FALSE(semaphore.try_acquire_for(1ms, 3u));
+                REQUIRE(semaphore.try_acquire_up_to(4u) == 2u);
+            }
+        }
+
+        WHEN("thread waits for 3 permits") {
+            std::thread waiting([&semaphore] { semaphore.acquire(3u); });
+            std::this_thread::sleep_for(1ms);
+
+            THEN("it's released once the missing permit is released") {
+                semaphore.release();
+                waiting.join();
+                REQUIRE_FALSE(semaphore.try_acquire());
+            }
+        }
+    }
+}
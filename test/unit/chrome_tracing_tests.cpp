@@ -0,0 +1,99 @@
+#include <catch.hpp>
+#include <n_threaded_task_queue.hpp>
+#include <unsafe_fifo_queue.hpp>
+#include <chrome_tracing.hpp>
+#include <stamped_task.hpp>
+#include <functional>
+#include <sstream>
+#include <string>
+#include "spy_thread.h"
+#include "test_configuration.h"
+
+namespace {
+    std::size_t occurrences(const std::string &text, const std::string &pattern) {
+        std::size_t count = 0u;
+        for (auto position = text.find(pattern); position != std::string::npos;
+             position = text.find(pattern, position + 1u)) {
+            ++count;
+        }
+        return count;
+    }
+}
+
+SCENARIO("tracing tasks of task queue", "[concurrent::chrome_tracing]") {
+    GIVEN("a 2-threaded fifo task queue with tracing") {
+        using task_type = concurrent::stamped_task<std::function<void(void)>>;
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<task_type>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::chrome_tracing
+        > task_queue(2);
+
+        WHEN("nothing else happens") {
+            std::ostringstream stream;
+            task_queue.instrumentation().write_chrome_trace(stream);
+            const auto trace = stream.str();
+
+            THEN("trace names both workers and has no task events") {
+                REQUIRE(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0u);
+                REQUIRE(occurrences(trace, "\"thread_name\"") == 2u);
+                REQUIRE(occurrences(trace, "\"ph\":\"X\"") == 0u);
+            }
+        }
+
+        WHEN("labelled and unlabelled tasks are executed") {
+            for (int i = 0; i < 4; ++i) {
+                task_queue.push(task_type("parse \"input\"", [] { std::this_thread::sleep_for(100us); }));
+                task_queue.push([] {});
+            }
+            task_queue.wait_for_tasks_completion();
+
+            std::ostringstream stream;
+            task_queue.instrumentation().write_chrome_trace(stream);
+            const auto trace = stream.str();
+
+            THEN("every task has complete event with its label") {
+                REQUIRE(occurrences(trace, "\"ph\":\"X\"") == 8u);
+                REQUIRE(occurrences(trace, "{\"name\":\"parse \\\"input\\\"\",\"cat\":\"task\"") == 4u);
+                REQUIRE(occurrences(trace, "{\"name\":\"task\",\"cat\":\"task\"") == 4u);
+            }
+
+            THEN("time spent in queue is traced as async events") {
+                REQUIRE(occurrences(trace, "\"ph\":\"b\"") == 8u);
+                REQUIRE(occurrences(trace, "\"ph\":\"e\"") == 8u);
+            }
+
+            THEN("queue depth is traced on every push") {
+                REQUIRE(occurrences(trace, "\"name\":\"queue depth\"") == 8u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded fifo task queue of plain functions with tracing") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::chrome_tracing
+        > task_queue(2);
+
+        WHEN("tasks are pushed and emplaced") {
+            for (int i = 0; i < 4; ++i) {
+                task_queue.push([] {});
+                task_queue.emplace([] {});
+            }
+            task_queue.wait_for_tasks_completion();
+
+            std::ostringstream stream;
+            task_queue.instrumentation().write_chrome_trace(stream);
+            const auto trace = stream.str();
+
+            THEN("time every task spent in queue is traced from its push") {
+                REQUIRE(occurrences(trace, "\"ph\":\"X\"") == 8u);
+                REQUIRE(occurrences(trace, "\"ph\":\"b\"") == 8u);
+                REQUIRE(occurrences(trace, "\"ph\":\"e\"") == 8u);
+            }
+        }
+    }
+}
@@ -3,6 +3,7 @@
 #include <mutex>
 #include <unsafe_fifo_queue.hpp>
 #include <functional>
+#include <thread>
 #include <barrier.hpp>
 #include <dynamic_task_queue.hpp>
 #include "spy_thread.h"
@@ -41,7 +42,7 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
             );
 
             THEN("the task should be finally completed and one new thread should be spawned") {
-                REQUIRE(concurrent::spy_thread::alive_threads.size() == 2);
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(2, config::default_timeout));
                 REQUIRE(barrier->wait_for(config::default_timeout));
             }
         }
@@ -56,7 +57,7 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
             task_queue.push(task);
 
             THEN("the task should be finally completed and one new thread should be spawned") {
-                REQUIRE(concurrent::spy_thread::alive_threads.size() == 2);
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(2, config::default_timeout));
                 REQUIRE(barrier->wait_for(config::default_timeout));
             }
         }
@@ -73,7 +74,7 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
             }
 
             THEN("4 new threads should be spawned and all tasks should be executed concurrently") {
-                REQUIRE(concurrent::spy_thread::alive_threads.size() == 5);
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(5, config::default_timeout));
                 REQUIRE(barrier->wait_for(config::default_timeout));
             }
         }
@@ -118,7 +119,7 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
             }
 
             THEN("8 threads are spawned") {
-                REQUIRE(concurrent::spy_thread::alive_threads.size() == 9);
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(9, config::default_timeout));
 
                 AND_WHEN("threads are released") {
                     REQUIRE(second_barrier->wait_for(config::default_timeout));
@@ -138,7 +139,7 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
                                 }
                                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
                             }
-                            REQUIRE(concurrent::spy_thread::alive_threads.size() == 5);
+                            REQUIRE(concurrent::spy_thread::wait_for_alive_threads(5, config::default_timeout));
                         }
                     }
                 }
@@ -166,4 +167,162 @@ SCENARIO("creating dynamic queue, adding and executing tasks", "[concurrent::dyn
         }
     }
 
-}
\ No newline at end of file
+    GIVEN("a 4-threaded fifo task queue with 2 spare workers") {
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                4,
+                8,
+                std::chrono::milliseconds(3),
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                2
+        );
+
+        WHEN("nothing else happens") {
+            THEN("spare workers should be spawned in background") {
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(3, config::default_timeout));
+            }
+        }
+
+        WHEN("spare workers are started and 2 tasks are pushed") {
+            REQUIRE(concurrent::spy_thread::wait_for_alive_threads(3, config::default_timeout));
+            auto barrier = std::make_shared<concurrent::barrier>(3);
+
+            for (auto i = 0u; i < 2u; ++i) {
+                task_queue.push(
+                        [barrier] {
+                            barrier->wait();
+                        }
+                );
+            }
+
+            THEN("tasks should be completed") {
+                REQUIRE(barrier->wait_for(config::default_timeout));
+            }
+        }
+    }
+
+    GIVEN("a 1-threaded fifo task queue with 1 spare worker") {
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                1,
+                3,
+                std::chrono::milliseconds(100),
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                1
+        );
+
+        WHEN("core worker is busy and a task is pushed") {
+            REQUIRE(concurrent::spy_thread::wait_for_alive_threads(2, config::default_timeout));
+            auto barrier = std::make_shared<concurrent::barrier>(3);
+            auto started = std::make_shared<concurrent::barrier>(2);
+
+            task_queue.push(
+                    [barrier, started] {
+                        started->wait();
+                        barrier->wait();
+                    }
+            );
+            REQUIRE(started->wait_for(config::default_timeout));
+
+            task_queue.push(
+                    [barrier] {
+                        barrier->wait();
+                    }
+            );
+
+            THEN("spare worker should run the task and be replaced") {
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(4, config::default_timeout));
+                REQUIRE(barrier->wait_for(config::default_timeout));
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded fifo task queue with idle timeout for core workers") {
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                2,
+                2,
+                std::chrono::milliseconds(3),
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                0u,
+                std::chrono::milliseconds(3)
+        );
+
+        WHEN("a task is pushed and completed") {
+            auto barrier = std::make_shared<concurrent::barrier>(2);
+
+            task_queue.push(
+                    [barrier] {
+                        barrier->wait();
+                    }
+            );
+
+            REQUIRE(barrier->wait_for(config::default_timeout));
+
+            THEN("core worker is finally killed") {
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(1, config::default_timeout));
+
+                AND_WHEN("another task is pushed") {
+                    auto second_barrier = std::make_shared<concurrent::barrier>(2);
+
+                    task_queue.push(
+                            [second_barrier] {
+                                second_barrier->wait();
+                            }
+                    );
+
+                    THEN("the task should be completed by a restarted core worker") {
+                        REQUIRE(second_barrier->wait_for(config::default_timeout));
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a 1-threaded fifo task queue with idle timeout for core workers and 1 spare worker") {
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                1,
+                2,
+                std::chrono::milliseconds(3),
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                1u,
+                std::chrono::milliseconds(3)
+        );
+
+        WHEN("the queue stays idle") {
+            THEN("the spare worker times out and only the cleaning thread is left") {
+                REQUIRE(concurrent::spy_thread::wait_for_alive_threads(1, config::default_timeout));
+
+                AND_WHEN("two tasks waiting for each other are pushed") {
+                    auto barrier = std::make_shared<concurrent::barrier>(3);
+
+                    for (auto i = 0u; i < 2u; ++i) {
+                        task_queue.push(
+                                [barrier] {
+                                    barrier->wait();
+                                }
+                        );
+                    }
+
+                    THEN("they're run by a core and a spare or dynamic worker, which time out afterwards") {
+                        REQUIRE(barrier->wait_for(config::default_timeout));
+                        REQUIRE(concurrent::spy_thread::wait_for_alive_threads(1, config::default_timeout));
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include <catch.hpp>
+#include <fair_task_queue.hpp>
+#include <latch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+SCENARIO("sharing workers between tenants", "[concurrent::fair_task_queue]") {
+    GIVEN("a 1-threaded fair task queue with tenants of weights 3 and 1") {
+        concurrent::fair_task_queue<> task_queue(1u);
+        task_queue.add_tenant("gold", 3u);
+        task_queue.add_tenant("bronze", 1u);
+
+        WHEN("both of them push many tasks while the worker is busy") {
+            concurrent::latch release(1u);
+            std::mutex order_mutex;
+            std::vector<std::string> order;
+
+            task_queue.push("gold", [&release] { release.wait(); });
+            for (int i = 0; i < 40; ++i) {
+                for (const auto tenant: {"gold", "bronze"}) {
+                    task_queue.push(tenant, [&order_mutex, &order, tenant] {
+                        std::lock_guard<std::mutex> lock(order_mutex);
+                        order.emplace_back(tenant);
+                    });
+                }
+            }
+            release.count_down();
+            task_queue.wait_for_tasks_completion();
+
+            THEN("they get workers in proportion to their weights") {
+                REQUIRE(order.size() == 80u);
+                REQUIRE(std::count(order.begin(), order.begin() + 40, "gold") == 30);
+                REQUIRE(task_queue.executed("gold") == 41u);
+                REQUIRE(task_queue.executed("bronze") == 40u);
+                REQUIRE(task_queue.size() == 0u);
+            }
+        }
+    }
+
+    GIVEN("a 4-threaded fair task queue with a tenant limited to 1 running task") {
+        concurrent::fair_task_queue<> task_queue(4u);
+        task_queue.add_tenant("noisy", 1u, 1u);
+        task_queue.add_tenant("quiet");
+
+        WHEN("the limited tenant pushes many tasks") {
+            std::atomic<int> running{0};
+            std::atomic<int> max_running{0};
+            concurrent::latch quiet_done(10u);
+
+            for (int i = 0; i < 20; ++i) {
+                task_queue.push("noisy", [&running, &max_running] {
+                    const auto now = ++running;
+                    auto max = max_running.load();
+                    while (now > max && !max_running.compare_exchange_weak(max, now)) {
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    --running;
+                });
+            }
+            for (int i = 0; i < 10; ++i) {
+                task_queue.push("quiet", [&quiet_done] { quiet_done.count_down(); });
+            }
+
+            THEN("its tasks run one at a time while others use the rest of workers") {
+                REQUIRE(quiet_done.wait_for(config::default_timeout));
+                task_queue.wait_for_tasks_completion();
+                REQUIRE(max_running == 1);
+                REQUIRE(task_queue.executed("noisy") == 20u);
+            }
+        }
+
+        WHEN("a task is pushed for an unknown tenant") {
+            THEN("an exception is thrown") {
+                REQUIRE_THROWS_AS(task_queue.push("unknown", [] {}), std::out_of_range);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded fair task queue with a tenant added with cap of 0 running tasks") {
+        concurrent::fair_task_queue<> task_queue(2u);
+        task_queue.add_tenant("capped", 1u, 0u);
+
+        WHEN("the tenant pushes tasks") {
+            concurrent::latch done(5u);
+
+            for (int i = 0; i < 5; ++i) {
+                task_queue.push("capped", [&done] { done.count_down(); });
+            }
+
+            THEN("they are still run") {
+                REQUIRE(done.wait_for(config::default_timeout));
+                task_queue.wait_for_tasks_completion();
+                REQUIRE(task_queue.executed("capped") == 5u);
+            }
+        }
+    }
+}
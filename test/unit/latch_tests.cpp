@@ -0,0 +1,110 @@
+#include <catch.hpp>
+#include <latch.hpp>
+#include <task_queues.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+SCENARIO("counting down latch", "[concurrent::latch]") {
+    GIVEN("a latch counting 3") {
+        concurrent::latch latch(3);
+
+        THEN("it isn't open") {
+            REQUIRE_FALSE(latch.try_wait());
+            REQUIRE(latch.count() == 3u);
+            REQUIRE_FALSE(latch.wait_for(10ms));
+        }
+
+        WHEN("it's counted down by 1 and 2") {
+            latch.count_down();
+            latch.count_down(2u);
+
+            THEN("it's open") {
+                REQUIRE(latch.try_wait());
+                REQUIRE(latch.count() == 0u);
+                REQUIRE(latch.wait_for(0ms));
+                latch.wait();
+            }
+        }
+
+        WHEN("threads wait for it") {
+            std::atomic<std::size_t> released{0u};
+            std::vector<std::thread> waiting;
+            for (int i = 0; i < 4; ++i) {
+                waiting.emplace_back([&latch, &released] {
+                    latch.wait();
+                    ++released;
+                });
+            }
+
+            AND_WHEN("it's counted down to zero by other threads") {
+                std::vector<std::thread> counting;
+                for (int i = 0; i < 3; ++i) {
+                    counting.emplace_back([&latch] { latch.count_down(); });
+                }
+                for (auto &thread: counting) {
+                    thread.join();
+                }
+
+                THEN("all waiting threads are released") {
+                    REQUIRE(latch.wait_for(config::default_timeout));
+                    for (auto &thread: waiting) {
+                        thread.join();
+                    }
+                    REQUIRE(released == 4u);
+                }
+            }
+
+            if (!latch.try_wait()) {
+                latch.count_down(latch.count());
+            }
+            for (auto &thread: waiting) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+    }
+
+    GIVEN("a 4-threaded task queue") {
+        concurrent::n_threaded_fifo_task_queue task_queue(4);
+
+        WHEN("100 tasks count down a shared latch") {
+            auto latch = std::make_shared<concurrent::latch>(100);
+            std::atomic<std::size_t> executed{0u};
+
+            for (int i = 0; i < 100; ++i) {
+                task_queue.push([latch, &executed] {
+                    ++executed;
+                    latch->count_down();
+                });
+            }
+
+            THEN("waiting for the latch waits for all of them") {
+                REQUIRE(latch->wait_for(config::default_timeout));
+                REQUIRE(executed == 100u);
+            }
+        }
+
+        WHEN("tasks count down latches owned by the waiting thread") {
+            std::atomic<std::size_t> executed{0u};
+
+            for (int round = 0; round < 100; ++round) {
+                concurrent::latch latch(4);
+                for (int i = 0; i < 4; ++i) {
+                    task_queue.push([&latch, &executed] {
+                        ++executed;
+                        latch.count_down();
+                    });
+                }
+                latch.wait();
+            }
+
+            THEN("every latch is released after all of its tasks") {
+                REQUIRE(executed == 400u);
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "test_configuration.h"
+
+namespace {
+    // Each task pushes the next one until `count` of them were run.
+    template <class TaskQueue>
+    void push_chain(TaskQueue &task_queue, std::atomic<int> &executed, int count, std::function<void()> observe) {
+        task_queue.push([&task_queue, &executed, count, observe] {
+            observe();
+            if (++executed < count) {
+                push_chain(task_queue, executed, count, observe);
+            }
+        });
+    }
+}
+
+SCENARIO("running tasks pushed by workers in local slots", "[concurrent::local_task_slots]") {
+    GIVEN("a 4-threaded fifo queue with local slots which aren't stolen") {
+        concurrent::n_threaded_fifo_task_queue task_queue(
+                4u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::eager,
+                concurrent::unbounded_capacity,
+                std::chrono::hours(1)
+        );
+
+        WHEN("a chain of tasks pushing each other is run") {
+            std::atomic<int> executed{0};
+            std::mutex threads_mutex;
+            std::set<std::thread::id> threads;
+
+            push_chain(task_queue, executed, 1000, [&threads_mutex, &threads] {
+                std::lock_guard<std::mutex> lock(threads_mutex);
+                threads.insert(std::this_thread::get_id());
+            });
+            task_queue.wait_for_tasks_completion();
+
+            THEN("all of them are run by the same worker before waiting finishes") {
+                REQUIRE(executed == 1000);
+                REQUIRE(threads.size() == 1u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded fifo queue with local slots stolen after 1ms") {
+        concurrent::n_threaded_fifo_task_queue task_queue(
+                2u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::eager,
+                concurrent::unbounded_capacity,
+                std::chrono::milliseconds(1)
+        );
+
+        WHEN("a task pushes another one and waits for it") {
+            concurrent::latch done(1u);
+            std::atomic_bool finished{false};
+
+            task_queue.push([&task_queue, &done, &finished] {
+                task_queue.push([&done] { done.count_down(); });
+                finished = done.wait_for(config::default_timeout);
+            });
+            task_queue.wait_for_tasks_completion();
+
+            THEN("the other worker steals it") {
+                REQUIRE(finished);
+            }
+        }
+    }
+
+    GIVEN("a 1-threaded fifo queue with capacity 1 and local slots") {
+        concurrent::n_threaded_fifo_task_queue task_queue(
+                1u,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::eager,
+                1u,
+                std::chrono::hours(1)
+        );
+
+        WHEN("a task pushes three others without waiting") {
+            std::atomic<int> executed{0};
+            std::atomic_bool second_pushed{false};
+            std::atomic_bool third_pushed{true};
+
+            task_queue.push([&task_queue, &executed, &second_pushed, &third_pushed] {
+                task_queue.emplace([&executed] { ++executed; });
+                second_pushed = task_queue.try_push([&executed] { ++executed; });
+                third_pushed = task_queue.try_push([&executed] { ++executed; });
+            });
+            task_queue.wait_for_tasks_completion();
+
+            THEN("a task displaced to the full queue isn't pushed") {
+                REQUIRE(second_pushed);
+                REQUIRE_FALSE(third_pushed);
+                REQUIRE(executed == 2);
+            }
+        }
+    }
+
+    GIVEN("a priority queue with local slots") {
+        concurrent::n_threaded_priority_task_queue task_queue(
+                2u,
+                concurrent::unsafe_priority_queue<int, std::function<void()>>(),
+                concurrent::startup_policy::eager,
+                concurrent::unbounded_capacity,
+                std::chrono::milliseconds(1)
+        );
+
+        WHEN("a task pushes another one") {
+            std::atomic<int> executed{0};
+            task_queue.push(std::make_pair(1, [&task_queue, &executed] {
+                task_queue.push(std::make_pair(1, [&executed] { ++executed; }));
+                ++executed;
+            }));
+            task_queue.wait_for_tasks_completion();
+
+            THEN("it's run from the shared queue") {
+                REQUIRE(executed == 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#include <catch.hpp>
+#include <adaptive_mutex.hpp>
+#include <ticket_mutex.hpp>
+#include <mcs_mutex.hpp>
+#include <futex_condition_variable.hpp>
+#include <n_threaded_task_queue.hpp>
+#include <dynamic_task_queue.hpp>
+#include <unsafe_fifo_queue.hpp>
+#include <semaphore.hpp>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "spy_thread.h"
+#include "test_configuration.h"
+
+namespace {
+    // Catch in CI has no templated test cases, so every mutex runs the
+    // same helpers.
+    template <class Mutex>
+    void require_mutual_exclusion() {
+        Mutex mutex;
+        std::size_t counter = 0u;
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&mutex, &counter] {
+                for (int j = 0; j < 10000; ++j) {
+                    std::lock_guard<Mutex> lock(mutex);
+                    ++counter;
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+
+        REQUIRE(counter == 40000u);
+    }
+
+    template <class Mutex>
+    void require_try_lock_fails_when_locked() {
+        Mutex mutex;
+        std::unique_lock<Mutex> lock(mutex);
+        bool locked = true;
+
+        std::thread([&mutex, &locked] { locked = mutex.try_lock(); }).join();
+        REQUIRE_FALSE(locked);
+
+        lock.unlock();
+        std::thread([&mutex, &locked] {
+            locked = mutex.try_lock();
+            if (locked) {
+                mutex.unlock();
+            }
+        }).join();
+        REQUIRE(locked);
+    }
+
+    // Several mutexes of the same kind held at once by one thread.
+    template <class Mutex>
+    void require_nested_locking() {
+        std::vector<std::unique_ptr<Mutex>> mutexes;
+        for (int i = 0; i < 12; ++i) {
+            mutexes.push_back(std::make_unique<Mutex>());
+        }
+
+        for (auto &mutex: mutexes) {
+            mutex->lock();
+        }
+        for (auto it = mutexes.rbegin(); it != mutexes.rend(); ++it) {
+            (*it)->unlock();
+        }
+        for (auto &mutex: mutexes) {
+            REQUIRE(mutex->try_lock());
+            mutex->unlock();
+        }
+    }
+
+    template <class Mutex>
+    void require_condition_variable_support() {
+        Mutex mutex;
+        concurrent::condition_variable_for_t<Mutex> condition_variable;
+        bool ready = false;
+
+        std::thread notifier([&] {
+            std::this_thread::sleep_for(1ms);
+            {
+                std::lock_guard<Mutex> lock(mutex);
+                ready = true;
+            }
+            condition_variable.notify_all();
+        });
+
+        std::unique_lock<Mutex> lock(mutex);
+        REQUIRE(condition_variable.wait_for(lock, config::default_timeout, [&ready] { return ready; }));
+        REQUIRE_FALSE(condition_variable.wait_for(lock, 1ms, [] { return false; }));
+        lock.unlock();
+        notifier.join();
+    }
+
+    template <class Mutex>
+    void require_task_queue_support() {
+        std::atomic<int> executed{0};
+        {
+            concurrent::n_threaded_task_queue<
+                    concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                    std::thread,
+                    concurrent::basic_semaphore<Mutex>,
+                    concurrent::no_instrumentation,
+                    Mutex
+            > task_queue(4);
+
+            for (int i = 0; i < 1000; ++i) {
+                task_queue.push([&executed] { ++executed; });
+            }
+            task_queue.wait_for_tasks_completion();
+            REQUIRE(executed == 1000);
+        }
+
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                std::thread,
+                concurrent::basic_semaphore<Mutex>,
+                std::chrono::milliseconds,
+                concurrent::no_instrumentation,
+                Mutex
+        > task_queue(1, 4);
+
+        for (int i = 0; i < 1000; ++i) {
+            task_queue.push([&executed] { ++executed; });
+        }
+        task_queue.wait_for_tasks_completion();
+        REQUIRE(executed == 2000);
+    }
+
+    template <class Mutex>
+    void require_mutex_policy() {
+        require_mutual_exclusion<Mutex>();
+        require_try_lock_fails_when_locked<Mutex>();
+        require_nested_locking<Mutex>();
+        require_condition_variable_support<Mutex>();
+        require_task_queue_support<Mutex>();
+    }
+}
+
+TEST_CASE("adaptive mutex policy", "[concurrent::adaptive_mutex]") {
+    require_mutex_policy<concurrent::adaptive_mutex>();
+}
+
+TEST_CASE("ticket mutex policy", "[concurrent::ticket_mutex]") {
+    require_mutex_policy<concurrent::ticket_mutex>();
+}
+
+TEST_CASE("mcs mutex policy", "[concurrent::mcs_mutex]") {
+    require_mutex_policy<concurrent::mcs_mutex>();
+}
+
+TEST_CASE("futex condition variable with standard mutex", "[concurrent::futex_condition_variable]") {
+    std::mutex mutex;
+    concurrent::futex_condition_variable condition_variable;
+    int woken = 0;
+    std::vector<std::thread> waiters;
+
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition_variable.wait(lock, [&woken] { return woken > 0; });
+            ++woken;
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = 1;
+    }
+    condition_variable.notify_all();
+    for (auto &waiter: waiters) {
+        waiter.join();
+    }
+
+    REQUIRE(woken == 4);
+}
@@ -3,11 +3,24 @@
 #include <mutex>
 #include <unsafe_fifo_queue.hpp>
 #include <functional>
+#include <algorithm>
 #include <barrier.hpp>
+#include <latch.hpp>
 #include <task_queue_extension.hpp>
 #include "spy_thread.h"
 #include "test_configuration.h"
 
+namespace {
+    std::size_t running_threads_count() {
+        std::lock_guard<std::mutex> lock(concurrent::spy_thread::alive_threads_mutex);
+        return std::count_if(
+                concurrent::spy_thread::alive_threads.begin(),
+                concurrent::spy_thread::alive_threads.end(),
+                [](const concurrent::spy_thread *thread) { return thread->joinable(); }
+        );
+    }
+}
+
 SCENARIO("creating task queue, adding and executing tasks", "[concurrent::n_threaded_task_queue]") {
     GIVEN("a 4-threaded fifo task queue") {
         concurrent::task_queue_extension<
@@ -184,4 +197,113 @@ SCENARIO("creating task queue, adding and executing tasks", "[concurrent::n_thre
         }
     }
 
-}
\ No newline at end of file
+    GIVEN("a lazily started 4-threaded fifo task queue") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                4,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::lazy
+        );
+
+        WHEN("nothing else happens") {
+            THEN("no threads should be running") {
+                REQUIRE(running_threads_count() == 0);
+            }
+        }
+
+        WHEN("a single task is pushed") {
+            auto barrier = std::make_shared<concurrent::barrier>(2);
+
+            task_queue.push(
+                    [barrier] {
+                        barrier->wait();
+                    }
+            );
+
+            THEN("the task should be completed and one thread should be running") {
+                REQUIRE(running_threads_count() == 1);
+                REQUIRE(barrier->wait_for(config::default_timeout));
+            }
+        }
+
+        WHEN("8 tasks waiting for a release are pushed") {
+            auto counter = std::make_shared<std::atomic_uint>(0);
+            auto release = std::make_shared<concurrent::latch>(1u);
+            for (int i = 0; i < 8; ++i) {
+                task_queue.push(
+                        [counter, release] {
+                            release->wait();
+                            (*counter)++;
+                        }
+                );
+            }
+
+            THEN("number of running threads should not exceed 4") {
+                const auto running = running_threads_count();
+                release->count_down();
+                REQUIRE(running == 4);
+            }
+
+            AND_WHEN("`wait_for_tasks_completion` is called") {
+                release->count_down();
+                task_queue.wait_for_tasks_completion();
+
+                THEN("all task are finished") {
+                    REQUIRE(*counter == 8);
+                }
+            }
+        }
+
+        WHEN("tasks are pushed one after another finished") {
+            auto counter = std::make_shared<std::atomic_uint>(0);
+            for (int i = 0; i < 8; ++i) {
+                task_queue.push(
+                        [counter] {
+                            (*counter)++;
+                        }
+                );
+                task_queue.wait_for_tasks_completion();
+            }
+
+            THEN("the idle worker runs them and no other thread is started") {
+                REQUIRE(*counter == 8);
+                REQUIRE(running_threads_count() == 1);
+            }
+        }
+    }
+
+    GIVEN("a 40-threaded fifo task queue started in parallel") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread
+        > task_queue(
+                40,
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>(),
+                concurrent::startup_policy::parallel
+        );
+
+        WHEN("nothing else happens") {
+            THEN("40 threads should be spawned") {
+                REQUIRE(concurrent::spy_thread::alive_threads.size() == 40);
+            }
+        }
+
+        WHEN("40 tasks are pushed") {
+            auto barrier = std::make_shared<concurrent::barrier>(41);
+
+            for (auto i = 0u; i < 40u; ++i) {
+                task_queue.push(
+                        [barrier] {
+                            barrier->wait();
+                        }
+                );
+            }
+
+            THEN("all should be executed concurrently") {
+                REQUIRE(barrier->wait_for(config::default_timeout));
+            }
+        }
+    }
+}
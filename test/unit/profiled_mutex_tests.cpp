@@ -0,0 +1,118 @@
+#include <catch.hpp>
+#include <n_threaded_task_queue.hpp>
+#include <dynamic_task_queue.hpp>
+#include <unsafe_fifo_queue.hpp>
+#include <profiled_mutex.hpp>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include "spy_thread.h"
+#include "test_configuration.h"
+
+SCENARIO("profiling mutex", "[concurrent::profiled_mutex]") {
+    GIVEN("a profiled mutex") {
+        concurrent::profiled_mutex<> mutex;
+
+        WHEN("it's locked twice at the same site without contention") {
+            for (int i = 0; i < 2; ++i) {
+                const auto lock = concurrent::lock_at(mutex, concurrent::lock_site::push);
+                std::this_thread::sleep_for(1ms);
+            }
+
+            const auto profile = mutex.profile();
+
+            THEN("both acquisitions are recorded as uncontended") {
+                REQUIRE(profile[concurrent::lock_site::push].acquisitions == 2u);
+                REQUIRE(profile[concurrent::lock_site::push].contended_acquisitions == 0u);
+                REQUIRE(profile[concurrent::lock_site::push].contended_ratio() == 0.0);
+            }
+
+            THEN("time of holding the mutex is recorded") {
+                REQUIRE(profile[concurrent::lock_site::push].hold_time >= 2ms);
+            }
+
+            THEN("other sites are untouched") {
+                REQUIRE(profile[concurrent::lock_site::pop].acquisitions == 0u);
+                REQUIRE(profile.total().acquisitions == 2u);
+            }
+        }
+
+        WHEN("it's locked while another thread holds it") {
+            std::atomic_bool locked{false};
+            std::thread holder([&mutex, &locked] {
+                auto lock = concurrent::lock_at(mutex, concurrent::lock_site::other);
+                locked = true;
+                std::this_thread::sleep_for(5ms);
+            });
+
+            while (!locked) {
+                std::this_thread::yield();
+            }
+            {
+                const auto lock = concurrent::lock_at(mutex, concurrent::lock_site::size);
+            }
+            holder.join();
+
+            const auto profile = mutex.profile();
+
+            THEN("acquisition is recorded as contended with time of waiting") {
+                REQUIRE(profile[concurrent::lock_site::size].acquisitions == 1u);
+                REQUIRE(profile[concurrent::lock_site::size].contended_acquisitions == 1u);
+                REQUIRE(profile[concurrent::lock_site::size].contended_ratio() == 1.0);
+                REQUIRE(profile[concurrent::lock_site::size].wait_time > 0ms);
+                REQUIRE(profile[concurrent::lock_site::size].max_wait_time == profile[concurrent::lock_site::size].wait_time);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded fifo task queue with profiled mutex") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::no_instrumentation,
+                concurrent::profiled_mutex<>
+        > task_queue(2);
+
+        WHEN("tasks are executed") {
+            for (int i = 0; i < 16; ++i) {
+                task_queue.push([] {});
+            }
+            task_queue.wait_for_tasks_completion();
+            task_queue.size();
+
+            const auto profile = task_queue.queue_mutex().profile();
+
+            THEN("locks are attributed to their call sites") {
+                REQUIRE(profile[concurrent::lock_site::push].acquisitions == 16u);
+                REQUIRE(profile[concurrent::lock_site::pop].acquisitions >= 16u);
+                REQUIRE(profile[concurrent::lock_site::size].acquisitions == 1u);
+                REQUIRE(profile[concurrent::lock_site::wait_for_tasks_completion].acquisitions >= 1u);
+            }
+        }
+    }
+
+    GIVEN("a dynamic fifo task queue with profiled mutex") {
+        concurrent::dynamic_task_queue<
+                concurrent::unsafe_fifo_queue<std::function<void(void)>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                std::chrono::milliseconds,
+                concurrent::no_instrumentation,
+                concurrent::profiled_mutex<>
+        > task_queue(1, 2);
+
+        WHEN("a task is executed") {
+            task_queue.push([] {});
+            task_queue.wait_for_tasks_completion();
+
+            const auto profile = task_queue.queue_mutex().profile();
+
+            THEN("worker spawning is attributed to cleaning thread") {
+                REQUIRE(profile[concurrent::lock_site::push].acquisitions == 1u);
+                REQUIRE(profile[concurrent::lock_site::cleaning_thread].acquisitions >= 1u);
+                REQUIRE(profile[concurrent::lock_site::pop].acquisitions >= 1u);
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#include <catch.hpp>
+#include <n_threaded_task_queue.hpp>
+#include <unsafe_fifo_queue.hpp>
+#include <unsafe_priority_queue.hpp>
+#include <unsafe_indexed_priority_queue.hpp>
+#include <priority_task_queue_extension.hpp>
+#include <queue_metrics.hpp>
+#include <stamped_task.hpp>
+#include <functional>
+#include "spy_thread.h"
+#include "test_configuration.h"
+
+TEST_CASE("latency histogram reports percentiles with bounded error", "[concurrent::latency_histogram]") {
+    concurrent::latency_histogram histogram;
+
+    for (auto value = 1u; value <= 1000u; ++value) {
+        histogram.record(value);
+    }
+
+    concurrent::histogram_snapshot snapshot;
+    histogram.add_to(snapshot);
+
+    REQUIRE(snapshot.count() == 1000u);
+    REQUIRE(snapshot.max() == 1000u);
+    REQUIRE(snapshot.value_at_percentile(100.0) == 1000u);
+    REQUIRE(snapshot.value_at_percentile(50.0) >= 500u);
+    REQUIRE(snapshot.value_at_percentile(50.0) <= 500u + 500u / 8u);
+    REQUIRE(snapshot.value_at_percentile(0.0) == 1u);
+}
+
+SCENARIO("collecting metrics of task queue", "[concurrent::queue_metrics]") {
+    GIVEN("a 4-threaded fifo task queue with metrics") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_fifo_queue<concurrent::stamped_task<std::function<void(void)>>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::queue_metrics
+        > task_queue(4);
+
+        WHEN("nothing else happens") {
+            const auto snapshot = task_queue.instrumentation().snapshot();
+
+            THEN("every worker has its own counters") {
+                REQUIRE(snapshot.workers.size() == 4u);
+            }
+
+            THEN("no task is counted") {
+                REQUIRE(snapshot.enqueued == 0u);
+                REQUIRE(snapshot.executed == 0u);
+            }
+        }
+
+        WHEN("16 tasks are executed") {
+            for (int i = 0; i < 16; ++i) {
+                task_queue.push([] { std::this_thread::sleep_for(100us); });
+            }
+            task_queue.wait_for_tasks_completion();
+
+            const auto snapshot = task_queue.instrumentation().snapshot();
+
+            THEN("all tasks are counted") {
+                REQUIRE(snapshot.enqueued == 16u);
+                REQUIRE(snapshot.dequeued == 16u);
+                REQUIRE(snapshot.executed == 16u);
+            }
+
+            THEN("queue wait time and execution time of every task are recorded") {
+                REQUIRE(snapshot.wait_time.count() == 16u);
+                REQUIRE(snapshot.execution_time.count() == 16u);
+                REQUIRE(snapshot.execution_time.value_at_percentile(50.0) >= 100000u);
+            }
+
+            THEN("time spent on tasks is counted as busy time") {
+                REQUIRE(snapshot.busy_time >= 16 * 100us);
+            }
+
+            THEN("queue depth high-water mark is recorded") {
+                REQUIRE(snapshot.queue_depth_high_water_mark >= 1u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded priority task queue of plain functions with metrics") {
+        concurrent::n_threaded_task_queue<
+                concurrent::unsafe_priority_queue<int, std::function<void(void)>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::queue_metrics
+        > task_queue(2);
+
+        WHEN("tasks are pushed and emplaced") {
+            for (int i = 0; i < 8; ++i) {
+                task_queue.push(std::make_pair(i, [] {}));
+                task_queue.emplace(i, [] {});
+            }
+            task_queue.wait_for_tasks_completion();
+
+            const auto snapshot = task_queue.instrumentation().snapshot();
+
+            THEN("queue wait time of every task is recorded") {
+                REQUIRE(snapshot.executed == 16u);
+                REQUIRE(snapshot.wait_time.count() == 16u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded indexed priority task queue of plain functions with metrics") {
+        concurrent::priority_task_queue_extension<concurrent::n_threaded_task_queue<
+                concurrent::unsafe_indexed_priority_queue<int, std::function<void(void)>>,
+                concurrent::spy_thread,
+                concurrent::semaphore,
+                concurrent::queue_metrics
+        >> task_queue(2);
+
+        WHEN("tasks are pushed with handles") {
+            for (int i = 0; i < 8; ++i) {
+                task_queue.push_with_handle(std::make_pair(i, [] {}));
+            }
+            task_queue.wait_for_tasks_completion();
+
+            const auto snapshot = task_queue.instrumentation().snapshot();
+
+            THEN("queue wait time of every task is recorded") {
+                REQUIRE(snapshot.executed == 8u);
+                REQUIRE(snapshot.wait_time.count() == 8u);
+            }
+        }
+    }
+}
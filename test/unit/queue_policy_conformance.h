@@ -0,0 +1,254 @@
+#pragma once
+
+#include <catch.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <unsafe_fifo_queue.hpp>
+#include <unsafe_lifo_queue.hpp>
+#include <unsafe_priority_queue.hpp>
+#include <unsafe_deadline_queue.hpp>
+#include <unsafe_indexed_priority_queue.hpp>
+
+// Requirements every queue policy used by task queues has to meet.
+// A policy is described by a family, which tells how to build its
+// elements carrying a value of any type and an ordering rank:
+//
+//     struct family {
+//         template <class T> using queue_type = ...;
+//         template <class T> static auto make(T value, int rank);
+//         template <class Queue, class T> static void emplace(Queue &queue, T &&value, int rank);
+//     };
+//
+// Ranks are ignored by policies which don't order elements by priority.
+// New policies should add their family and run the whole suite.
+namespace queue_policy_conformance {
+    struct fifo_family {
+        template <class T>
+        using queue_type = concurrent::unsafe_fifo_queue<T>;
+
+        template <class T>
+        static T make(T value, int) {
+            return value;
+        }
+
+        template <class Queue, class T>
+        static void emplace(Queue &queue, T &&value, int) {
+            queue.emplace(std::forward<T>(value));
+        }
+    };
+
+    struct lifo_family {
+        template <class T>
+        using queue_type = concurrent::unsafe_lifo_queue<T>;
+
+        template <class T>
+        static T make(T value, int) {
+            return value;
+        }
+
+        template <class Queue, class T>
+        static void emplace(Queue &queue, T &&value, int) {
+            queue.emplace(std::forward<T>(value));
+        }
+    };
+
+    struct priority_family {
+        template <class T>
+        using queue_type = concurrent::unsafe_priority_queue<int, T>;
+
+        template <class T>
+        static std::pair<const int, T> make(T value, int rank) {
+            return {rank, std::move(value)};
+        }
+
+        template <class Queue, class T>
+        static void emplace(Queue &queue, T &&value, int rank) {
+            queue.emplace(rank, std::forward<T>(value));
+        }
+    };
+
+    struct indexed_priority_family {
+        template <class T>
+        using queue_type = concurrent::unsafe_indexed_priority_queue<int, T>;
+
+        template <class T>
+        static std::pair<int, T> make(T value, int rank) {
+            return {rank, std::move(value)};
+        }
+
+        template <class Queue, class T>
+        static void emplace(Queue &queue, T &&value, int rank) {
+            queue.emplace(rank, std::forward<T>(value));
+        }
+    };
+
+    struct deadline_family {
+        template <class T>
+        using queue_type = concurrent::unsafe_deadline_queue<T>;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        // far enough for no deadline to pass during the suite
+        static time_point deadline(int rank) {
+            static const auto base = std::chrono::steady_clock::now() + std::chrono::hours(24);
+            return base + std::chrono::milliseconds(rank);
+        }
+
+        template <class T>
+        static std::pair<const time_point, T> make(T value, int rank) {
+            return {deadline(rank), std::move(value)};
+        }
+
+        template <class Queue, class T>
+        static void emplace(Queue &queue, T &&value, int rank) {
+            queue.emplace(deadline(rank), std::forward<T>(value));
+        }
+    };
+
+    template <class Family>
+    void require_member_types() {
+        using queue_type = typename Family::template queue_type<int>;
+
+        static_assert(
+                std::is_same<typename queue_type::poped_value_type, int>::value,
+                "queue pops values it was given"
+        );
+        static_assert(
+                std::is_same<decltype(std::declval<queue_type &>().pop()), typename queue_type::poped_value_type>::value,
+                "pop returns poped_value_type"
+        );
+        static_assert(
+                std::is_constructible<queue_type, typename queue_type::container_type>::value,
+                "queue is constructible from its container"
+        );
+        static_assert(
+                std::is_default_constructible<queue_type>::value,
+                "queue is default constructible"
+        );
+    }
+
+    template <class Family>
+    void require_empty_queue_behaviour() {
+        typename Family::template queue_type<int> queue;
+
+        REQUIRE(queue.empty());
+        REQUIRE(queue.size() == 0u);
+
+        queue.clear();
+        REQUIRE(queue.empty());
+    }
+
+    // Pushed copies are independent of their sources.
+    template <class Family>
+    void require_push_copies_values() {
+        typename Family::template queue_type<std::vector<int>> queue;
+        const auto element = Family::make(std::vector<int>{1, 2, 3}, 0);
+
+        queue.push(element);
+        queue.push(element);
+
+        REQUIRE(queue.size() == 2u);
+        REQUIRE(queue.pop() == std::vector<int>({1, 2, 3}));
+        REQUIRE(queue.pop() == std::vector<int>({1, 2, 3}));
+        REQUIRE(Family::make(std::vector<int>{1, 2, 3}, 0) == element);
+    }
+
+    template <class Family>
+    void require_move_only_values_support() {
+        typename Family::template queue_type<std::unique_ptr<int>> queue;
+
+        for (int i = 0; i < 8; ++i) {
+            Family::emplace(queue, std::make_unique<int>(i), 0);
+        }
+
+        std::vector<int> popped;
+        while (!queue.empty()) {
+            popped.push_back(*queue.pop());
+        }
+        std::sort(popped.begin(), popped.end());
+
+        REQUIRE(popped == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+    }
+
+    template <class Family>
+    void require_clear_removes_all_values() {
+        typename Family::template queue_type<int> queue;
+        for (int i = 0; i < 16; ++i) {
+            queue.push(Family::make(i, i % 3));
+        }
+
+        queue.clear();
+
+        REQUIRE(queue.empty());
+        REQUIRE(queue.size() == 0u);
+
+        queue.push(Family::make(42, 0));
+        REQUIRE(queue.pop() == 42);
+    }
+
+    // Random mix of pushes and pops never loses, duplicates nor damages
+    // values, which are large enough to live on the heap.
+    template <class Family>
+    void require_values_are_preserved_in_push_pop_mix() {
+        typename Family::template queue_type<std::vector<int>> queue;
+        std::mt19937 random(7u);
+        std::vector<int> pushed;
+        std::vector<int> popped;
+        std::size_t size = 0u;
+
+        for (int i = 0; i < 4096; ++i) {
+            if (size > 0u && random() % 100u < 45u) {
+                const auto value = queue.pop();
+                REQUIRE(value.size() == 64u);
+                REQUIRE(std::all_of(value.begin(), value.end(), [&value](int element) {
+                    return element == value.front();
+                }));
+                popped.push_back(value.front());
+                --size;
+            } else {
+                queue.push(Family::make(std::vector<int>(64u, i), static_cast<int>(random() % 8u)));
+                pushed.push_back(i);
+                ++size;
+            }
+
+            REQUIRE(queue.size() == size);
+            REQUIRE(queue.empty() == (size == 0u));
+        }
+
+        while (!queue.empty()) {
+            popped.push_back(queue.pop().front());
+        }
+        std::sort(popped.begin(), popped.end());
+
+        REQUIRE(popped == pushed);
+    }
+
+    // Values 0, 1, 2 ... with given ranks pushed at once and popped.
+    template <class Family>
+    std::vector<int> pop_order(const std::vector<int> &ranks) {
+        typename Family::template queue_type<int> queue;
+        for (auto i = 0u; i < ranks.size(); ++i) {
+            queue.push(Family::make(static_cast<int>(i), ranks[i]));
+        }
+
+        std::vector<int> popped;
+        while (!queue.empty()) {
+            popped.push_back(queue.pop());
+        }
+        return popped;
+    }
+
+    template <class Family>
+    void require_conformance() {
+        require_member_types<Family>();
+        require_empty_queue_behaviour<Family>();
+        require_push_copies_values<Family>();
+        require_move_only_values_support<Family>();
+        require_clear_removes_all_values<Family>();
+        require_values_are_preserved_in_push_pop_mix<Family>();
+    }
+}
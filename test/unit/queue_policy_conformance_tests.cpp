@@ -0,0 +1,45 @@
+#include <catch.hpp>
+#include <vector>
+#include "queue_policy_conformance.h"
+
+using namespace queue_policy_conformance;
+
+TEST_CASE("fifo queue policy conformance", "[concurrent::unsafe_fifo_queue]") {
+    require_conformance<fifo_family>();
+
+    SECTION("values are popped in order they were pushed") {
+        REQUIRE(pop_order<fifo_family>({2, 0, 1, 2, 0}) == std::vector<int>({0, 1, 2, 3, 4}));
+    }
+}
+
+TEST_CASE("lifo queue policy conformance", "[concurrent::unsafe_lifo_queue]") {
+    require_conformance<lifo_family>();
+
+    SECTION("values are popped in reversed order") {
+        REQUIRE(pop_order<lifo_family>({2, 0, 1, 2, 0}) == std::vector<int>({4, 3, 2, 1, 0}));
+    }
+}
+
+TEST_CASE("priority queue policy conformance", "[concurrent::unsafe_priority_queue]") {
+    require_conformance<priority_family>();
+
+    SECTION("values are popped from the highest rank, equal ones in order they were pushed") {
+        REQUIRE(pop_order<priority_family>({2, 0, 1, 2, 0}) == std::vector<int>({0, 3, 2, 1, 4}));
+    }
+}
+
+TEST_CASE("indexed priority queue policy conformance", "[concurrent::unsafe_indexed_priority_queue]") {
+    require_conformance<indexed_priority_family>();
+
+    SECTION("values are popped from the highest rank, equal ones in order they were pushed") {
+        REQUIRE(pop_order<indexed_priority_family>({2, 0, 1, 2, 0}) == std::vector<int>({0, 3, 2, 1, 4}));
+    }
+}
+
+TEST_CASE("deadline queue policy conformance", "[concurrent::unsafe_deadline_queue]") {
+    require_conformance<deadline_family>();
+
+    SECTION("values are popped from the earliest deadline, equal ones in order they were pushed") {
+        REQUIRE(pop_order<deadline_family>({2, 0, 1, 2, 0}) == std::vector<int>({1, 4, 2, 0, 3}));
+    }
+}
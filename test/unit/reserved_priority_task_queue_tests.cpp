@@ -0,0 +1,53 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <utility>
+#include "test_configuration.h"
+
+SCENARIO("reserving workers for high priority tasks", "[concurrent::reserved_priority_task_queue]") {
+    GIVEN("a 2-threaded priority task queue with 1 worker reserved for priority 10") {
+        concurrent::n_threaded_reserved_priority_task_queue task_queue(2u, 1u, 10);
+
+        WHEN("the other worker is busy with a long low priority task") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            concurrent::latch urgent_done(1u);
+            std::atomic_bool low_executed{false};
+
+            task_queue.emplace(0, [&started, &release] {
+                started.count_down();
+                release.wait();
+            });
+            started.wait();
+            task_queue.emplace(0, [&low_executed] { low_executed = true; });
+            task_queue.push(std::make_pair(10, [&urgent_done] { urgent_done.count_down(); }));
+
+            THEN("high priority task is run by the reserved worker and low priority one waits") {
+                const auto urgent_finished = urgent_done.wait_for(config::default_timeout);
+                const auto low_pending = !low_executed && task_queue.size() == 1u;
+                release.count_down();
+                task_queue.wait_for_tasks_completion();
+
+                REQUIRE(urgent_finished);
+                REQUIRE(low_pending);
+                REQUIRE(low_executed);
+                REQUIRE(task_queue.reserved_workers() == 1u);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded priority task queue with 2 workers reserved for priority 10") {
+        concurrent::n_threaded_reserved_priority_task_queue task_queue(2u, 2u, 10);
+
+        WHEN("a low priority task is pushed") {
+            concurrent::latch done(1u);
+            task_queue.emplace(0, [&done] { done.count_down(); });
+
+            THEN("only 1 worker is reserved and the other one runs it") {
+                REQUIRE(done.wait_for(config::default_timeout));
+                REQUIRE(task_queue.reserved_workers() == 1u);
+            }
+        }
+    }
+}
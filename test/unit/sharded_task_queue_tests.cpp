@@ -0,0 +1,203 @@
+#include <catch.hpp>
+#include <sharded_task_queue.hpp>
+#include <task_queues.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+SCENARIO("routing tasks by key", "[concurrent::sharded_task_queue]") {
+    GIVEN("a 4-threaded sharded task queue which doesn't steal") {
+        concurrent::sharded_task_queue<> task_queue(4u, 1000000u, std::chrono::hours(1));
+
+        WHEN("tasks with 16 keys are pushed") {
+            std::mutex threads_mutex;
+            std::map<int, std::set<std::thread::id>> threads_by_key;
+
+            for (int i = 0; i < 1000; ++i) {
+                const auto key = i % 16;
+                task_queue.push(key, [&threads_mutex, &threads_by_key, key] {
+                    std::lock_guard<std::mutex> lock(threads_mutex);
+                    threads_by_key[key].insert(std::this_thread::get_id());
+                });
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("tasks with the same key are run by the same worker") {
+                REQUIRE(threads_by_key.size() == 16u);
+                for (const auto &threads: threads_by_key) {
+                    REQUIRE(threads.second.size() == 1u);
+                }
+                REQUIRE(task_queue.stolen_tasks() == 0u);
+                REQUIRE(task_queue.size() == 0u);
+            }
+        }
+    }
+
+    GIVEN("a sharded task queue constructed for 0 threads") {
+        concurrent::sharded_task_queue<> task_queue(0u);
+
+        WHEN("tasks with and without keys are pushed") {
+            std::atomic<int> executed(0);
+
+            for (int i = 0; i < 10; ++i) {
+                task_queue.push(i, [&executed] { ++executed; });
+                task_queue.push([&executed] { ++executed; });
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("they are run by the single lane") {
+                REQUIRE(task_queue.lanes() == 1u);
+                REQUIRE(executed == 20);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded sharded task queue") {
+        concurrent::sharded_task_queue<> task_queue(2u);
+
+        WHEN("worker of a lane is blocked by a long task") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            concurrent::latch done(10u);
+
+            task_queue.push(7, [&started, &release] {
+                started.count_down();
+                release.wait();
+            });
+            started.wait();
+            for (int i = 0; i < 10; ++i) {
+                task_queue.push(7, [&done] { done.count_down(); });
+            }
+
+            THEN("other tasks of the lane are run by the idle worker") {
+                const auto finished = done.wait_for(config::default_timeout);
+                release.count_down();
+
+                REQUIRE(finished);
+                REQUIRE(task_queue.stolen_tasks() > 0u);
+            }
+        }
+
+        WHEN("tasks are pushed and the queue is destroyed") {
+            std::atomic<int> executed{0};
+            {
+                concurrent::sharded_task_queue<> destroyed(2u);
+                for (int i = 0; i < 100; ++i) {
+                    destroyed.push(i, [&executed] { ++executed; });
+                }
+            }
+
+            THEN("all of them are run") {
+                REQUIRE(executed == 100);
+            }
+        }
+    }
+}
+
+SCENARIO("pushing from many producers to lanes", "[concurrent::multi_lane_task_queue]") {
+    GIVEN("lane selectors") {
+        concurrent::round_robin_lane_selector round_robin;
+        concurrent::thread_lane_selector thread_lane;
+
+        THEN("round robin visits all lanes in turn") {
+            const auto first = round_robin(4u);
+            for (auto i = 1u; i < 8u; ++i) {
+                REQUIRE(round_robin(4u) == (first + i) % 4u);
+            }
+        }
+
+        THEN("thread selector always picks the same lane for a thread") {
+            const auto lane = thread_lane(4u);
+            REQUIRE(lane < 4u);
+            REQUIRE(thread_lane(4u) == lane);
+        }
+    }
+
+    GIVEN("a 4-threaded multi-lane fifo task queue") {
+        concurrent::multi_lane_fifo_task_queue task_queue(4u);
+
+        WHEN("8 producers push tasks") {
+            std::atomic<int> executed{0};
+            std::vector<std::thread> producers;
+            for (int i = 0; i < 8; ++i) {
+                producers.emplace_back([&task_queue, &executed] {
+                    for (int j = 0; j < 1000; ++j) {
+                        task_queue.push([&executed] { ++executed; });
+                    }
+                });
+            }
+            for (auto &producer: producers) {
+                producer.join();
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("all of them are run") {
+                REQUIRE(executed == 8000);
+                REQUIRE(task_queue.size() == 0u);
+            }
+        }
+
+        WHEN("a task is pushed with result") {
+            auto result = task_queue.push_with_result([] { return 42; });
+
+            THEN("its result is returned") {
+                REQUIRE(result.get() == 42);
+            }
+        }
+    }
+
+    GIVEN("a 2-threaded multi-lane fifo task queue used as a task queue") {
+        concurrent::multi_lane_fifo_task_queue multi_lane_queue(2u);
+        concurrent::default_task_queue &task_queue = multi_lane_queue;
+
+        WHEN("tasks are queued behind tasks blocking both workers and cleared") {
+            concurrent::latch started(2u);
+            concurrent::latch release(1u);
+            std::atomic<int> executed{0};
+
+            for (int i = 0; i < 2; ++i) {
+                task_queue.push([&started, &release] {
+                    started.count_down();
+                    release.wait_for(config::default_timeout);
+                });
+            }
+            started.wait();
+            for (int i = 0; i < 10; ++i) {
+                task_queue.push([&executed] { ++executed; });
+            }
+            const auto queued = task_queue.size();
+            const auto empty_before = task_queue.empty();
+            task_queue.clear();
+            const auto empty_after = task_queue.empty();
+            release.count_down();
+            multi_lane_queue.wait_for_tasks_completion();
+
+            THEN("they are removed without being run") {
+                REQUIRE(queued == 10u);
+                REQUIRE_FALSE(empty_before);
+                REQUIRE(empty_after);
+                REQUIRE(task_queue.size() == 0u);
+                REQUIRE(executed == 0);
+            }
+        }
+
+        WHEN("waiting until tasks are taken from the queue") {
+            std::atomic<int> executed{0};
+
+            for (int i = 0; i < 1000; ++i) {
+                task_queue.push([&executed] { ++executed; });
+            }
+            task_queue.wait_until_is_empty();
+
+            THEN("no task is queued") {
+                REQUIRE(task_queue.empty());
+                REQUIRE(executed >= 998);
+            }
+        }
+    }
+}
@@ -4,6 +4,25 @@
 std::vector<concurrent::spy_thread *> concurrent::spy_thread::alive_threads;
 std::mutex concurrent::spy_thread::alive_threads_mutex;
 
+bool concurrent::spy_thread::wait_for_alive_threads(std::size_t count, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(alive_threads_mutex);
+            if (alive_threads.size() == count) {
+                return true;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
 void concurrent::spy_thread::join() {
     m_underlying_thread.join();
 }
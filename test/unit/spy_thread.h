@@ -3,6 +3,7 @@
 #include <thread>
 #include <vector>
 #include <mutex>
+#include <chrono>
 
 namespace concurrent {
     class spy_thread {
@@ -19,6 +20,9 @@ namespace concurrent {
             alive_threads.push_back(this);
         }
 
+        // threads may be spawned asynchronously, so tests have to wait for them
+        static bool wait_for_alive_threads(std::size_t count, std::chrono::milliseconds timeout);
+
         spy_thread &operator=(spy_thread &&other) noexcept;
         bool joinable() const;
         void join();
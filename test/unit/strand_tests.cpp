@@ -0,0 +1,183 @@
+#include <catch.hpp>
+#include <strand.hpp>
+#include <task_queues.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "test_configuration.h"
+
+namespace {
+    // Tasks of every strand are run one at a time, in push order.
+    template <class TaskQueue, class... Args>
+    void require_serial_fifo_execution(TaskQueue &task_queue, Args... strand_args) {
+        constexpr int strands_count = 8;
+        constexpr int tasks_per_strand = 500;
+
+        struct connection {
+            std::unique_ptr<concurrent::strand<TaskQueue>> strand;
+            std::atomic<int> running{0};
+            std::atomic_bool overlapped{false};
+            std::vector<int> order;
+        };
+
+        std::vector<connection> connections(strands_count);
+        for (auto &connection: connections) {
+            connection.strand = std::make_unique<concurrent::strand<TaskQueue>>(task_queue, strand_args...);
+        }
+
+        for (int i = 0; i < tasks_per_strand; ++i) {
+            for (auto &connection: connections) {
+                connection.strand->push([&connection, i] {
+                    if (connection.running.fetch_add(1) != 0) {
+                        connection.overlapped = true;
+                    }
+                    connection.order.push_back(i);
+                    connection.running.fetch_sub(1);
+                });
+            }
+        }
+        task_queue.wait_for_tasks_completion();
+
+        for (auto &connection: connections) {
+            REQUIRE_FALSE(connection.overlapped);
+            REQUIRE(connection.order.size() == static_cast<std::size_t>(tasks_per_strand));
+            for (int i = 0; i < tasks_per_strand; ++i) {
+                REQUIRE(connection.order[i] == i);
+            }
+        }
+    }
+
+    // Queue whose pushes fail while `failing` is set, pushed tasks are run
+    // by the test.
+    struct failing_task_queue {
+        using pushed_value_type = std::function<void()>;
+
+        bool failing{false};
+        std::vector<std::function<void()>> tasks;
+
+        void push(std::function<void()> task) {
+            if (failing) {
+                throw std::runtime_error("push failed");
+            }
+            tasks.push_back(std::move(task));
+        }
+
+        void run_all() {
+            while (!tasks.empty()) {
+                auto task = std::move(tasks.front());
+                tasks.erase(tasks.begin());
+                task();
+            }
+        }
+    };
+
+    // Queue which is full for tasks pushed without blocking.
+    struct full_task_queue: failing_task_queue {
+        bool try_push(std::function<void()> &&) {
+            return false;
+        }
+    };
+}
+
+SCENARIO("running tasks in strands", "[concurrent::strand]") {
+    GIVEN("a 4-threaded fifo task queue") {
+        concurrent::n_threaded_fifo_task_queue task_queue(4u);
+
+        THEN("tasks of each strand are run serially in push order") {
+            require_serial_fifo_execution(task_queue);
+        }
+
+        THEN("strands with single task batches keep the order") {
+            require_serial_fifo_execution(task_queue, 1u);
+        }
+
+        THEN("strands with empty batches run single task batches") {
+            require_serial_fifo_execution(task_queue, 0u);
+        }
+
+        WHEN("a strand is destroyed before its tasks have run") {
+            std::atomic<int> executed{0};
+            {
+                concurrent::strand<concurrent::n_threaded_fifo_task_queue> strand(task_queue);
+                for (int i = 0; i < 100; ++i) {
+                    strand.push([&executed] { ++executed; });
+                }
+            }
+
+            THEN("all of them are run") {
+                task_queue.wait_for_tasks_completion();
+                REQUIRE(executed == 100);
+            }
+        }
+
+        WHEN("a task result is requested") {
+            concurrent::strand<concurrent::n_threaded_fifo_task_queue> strand(task_queue);
+            auto result = strand.push_with_result([] { return 4; });
+
+            THEN("it's returned by the future") {
+                REQUIRE(result.get() == 4);
+            }
+        }
+    }
+
+    GIVEN("a 4-threaded priority task queue") {
+        concurrent::n_threaded_priority_task_queue task_queue(4u);
+
+        THEN("tasks of each strand are run serially in push order") {
+            require_serial_fifo_execution(task_queue, concurrent::strand<decltype(task_queue)>::default_batch_size, 5);
+        }
+    }
+
+    GIVEN("a strand over a task queue whose push fails") {
+        failing_task_queue task_queue;
+        concurrent::strand<failing_task_queue> strand(task_queue, 1u);
+        std::vector<int> order;
+
+        WHEN("scheduling the first task throws") {
+            task_queue.failing = true;
+            REQUIRE_THROWS_AS(strand.push([&order] { order.push_back(1); }), std::runtime_error);
+            task_queue.failing = false;
+            strand.push([&order] { order.push_back(2); });
+            task_queue.run_all();
+
+            THEN("the strand is scheduled again by the next push") {
+                REQUIRE(order == std::vector<int>{1, 2});
+            }
+        }
+
+        WHEN("scheduling the next batch throws") {
+            strand.push([&order] { order.push_back(1); });
+            strand.push([&order] { order.push_back(2); });
+            task_queue.failing = true;
+            REQUIRE_THROWS_AS(task_queue.run_all(), std::runtime_error);
+            task_queue.failing = false;
+            strand.push([&order] { order.push_back(3); });
+            task_queue.run_all();
+
+            THEN("the strand is scheduled again by the next push") {
+                REQUIRE(order == std::vector<int>{1, 2, 3});
+            }
+        }
+    }
+
+    GIVEN("a strand with batches of 1 task on a queue which is full for its workers") {
+        full_task_queue task_queue;
+        concurrent::strand<full_task_queue> strand(task_queue, 1u);
+        std::vector<int> order;
+
+        WHEN("tasks are pushed and the drain task is run") {
+            for (int i = 1; i <= 3; ++i) {
+                strand.push([&order, i] { order.push_back(i); });
+            }
+            const auto drain_tasks = task_queue.tasks.size();
+            task_queue.run_all();
+
+            THEN("the worker runs all batches without pushing it again") {
+                REQUIRE(drain_tasks == 1u);
+                REQUIRE(order == std::vector<int>{1, 2, 3});
+                REQUIRE(task_queue.tasks.empty());
+            }
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <superstep_executor.hpp>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+SCENARIO("running supersteps on task queue", "[concurrent::superstep_executor]") {
+    GIVEN("an executor with 4 lanes over a 3-threaded task queue") {
+        concurrent::n_threaded_fifo_task_queue task_queue(3);
+        concurrent::superstep_executor<concurrent::n_threaded_fifo_task_queue> executor(task_queue, 4);
+
+        WHEN("10 partitions run 20 iterations") {
+            constexpr std::size_t partitions = 10u;
+            constexpr std::size_t iterations = 20u;
+            std::vector<std::atomic<std::size_t>> finished_iterations(partitions);
+            std::vector<std::thread::id> threads(partitions);
+            std::atomic_bool in_lockstep{true};
+            std::atomic_bool same_thread{true};
+            std::vector<std::size_t> completed_iterations;
+
+            executor.run(
+                    partitions,
+                    iterations,
+                    [&](std::size_t partition, std::size_t iteration) {
+                        // every partition has to have finished previous iteration
+                        for (const auto &finished: finished_iterations) {
+                            if (finished.load() < iteration) {
+                                in_lockstep = false;
+                            }
+                        }
+                        if (iteration == 0u) {
+                            threads[partition] = std::this_thread::get_id();
+                        } else if (threads[partition] != std::this_thread::get_id()) {
+                            same_thread = false;
+                        }
+                        finished_iterations[partition] = iteration + 1u;
+                    },
+                    [&](std::size_t iteration) {
+                        completed_iterations.push_back(iteration);
+                    }
+            );
+
+            THEN("all iterations of all partitions are run") {
+                for (const auto &finished: finished_iterations) {
+                    REQUIRE(finished.load() == iterations);
+                }
+            }
+
+            THEN("iteration starts after all partitions finished the previous one") {
+                REQUIRE(in_lockstep);
+            }
+
+            THEN("partition is always run by the same thread") {
+                REQUIRE(same_thread);
+            }
+
+            THEN("step completion is called after every iteration") {
+                REQUIRE(completed_iterations.size() == iterations);
+                for (auto i = 0u; i < iterations; ++i) {
+                    REQUIRE(completed_iterations[i] == i);
+                }
+            }
+        }
+
+        WHEN("step throws in the middle of computation") {
+            std::atomic<std::size_t> steps{0u};
+            auto run = [&] {
+                executor.run(8u, 10u, [&steps](std::size_t partition, std::size_t iteration) {
+                    ++steps;
+                    if (partition == 5u && iteration == 3u) {
+                        throw std::runtime_error("step failed");
+                    }
+                });
+            };
+
+            THEN("exception is rethrown and following iterations are skipped") {
+                REQUIRE_THROWS_AS(run(), std::runtime_error);
+                REQUIRE(steps <= 8u * 4u);
+            }
+
+            THEN("executor can be used again") {
+                REQUIRE_THROWS_AS(run(), std::runtime_error);
+                std::atomic<std::size_t> second_steps{0u};
+                executor.run(8u, 10u, [&second_steps](std::size_t, std::size_t) { ++second_steps; });
+                REQUIRE(second_steps == 80u);
+            }
+        }
+    }
+
+    GIVEN("an executor with 4 lanes over a 4-threaded task queue with idle workers") {
+        concurrent::n_threaded_fifo_task_queue task_queue(4);
+        concurrent::superstep_executor<concurrent::n_threaded_fifo_task_queue> executor(
+                task_queue,
+                4,
+                std::chrono::seconds(1)
+        );
+
+        WHEN("4 partitions run 100 short iterations") {
+            std::vector<std::thread::id> threads(4u);
+            executor.run(4u, 100u, [&threads](std::size_t partition, std::size_t iteration) {
+                if (iteration == 0u) {
+                    threads[partition] = std::this_thread::get_id();
+                }
+            });
+
+            THEN("lanes other than the first one are run by workers") {
+                REQUIRE(threads[0] == std::this_thread::get_id());
+                const std::set<std::thread::id> distinct(threads.begin(), threads.end());
+                REQUIRE(distinct.size() == 4u);
+            }
+        }
+    }
+
+    GIVEN("an executor with 4 lanes over a 1-threaded task queue whose worker is busy") {
+        concurrent::n_threaded_fifo_task_queue task_queue(1);
+        concurrent::superstep_executor<concurrent::n_threaded_fifo_task_queue> executor(task_queue, 4);
+        std::atomic_bool released{false};
+        task_queue.push([&released] {
+            while (!released) {
+                std::this_thread::yield();
+            }
+        });
+
+        WHEN("8 partitions run 5 iterations") {
+            std::atomic<std::size_t> steps{0u};
+            executor.run(8u, 5u, [&steps](std::size_t, std::size_t) { ++steps; });
+            released = true;
+
+            THEN("calling thread runs all lanes") {
+                REQUIRE(steps == 40u);
+            }
+        }
+
+        released = true;
+        task_queue.wait_for_tasks_completion();
+    }
+}
@@ -0,0 +1,188 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <unsafe_deadline_queue.hpp>
+#include <latch.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "test_configuration.h"
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+}
+
+SCENARIO("handling missed deadlines", "[concurrent::unsafe_deadline_queue]") {
+    const auto now = clock_type::now();
+    const auto passed = now - std::chrono::seconds(1);
+    const auto future = now + std::chrono::hours(1);
+
+    GIVEN("a deadline queue which runs late values") {
+        concurrent::unsafe_deadline_queue<int> queue;
+
+        WHEN("a value with passed deadline is pushed") {
+            queue.emplace(future, 1);
+            queue.emplace(passed, 0);
+
+            THEN("it's popped first and counted as missed") {
+                REQUIRE(queue.pop() == 0);
+                REQUIRE(queue.pop() == 1);
+                REQUIRE(queue.counters()->missed == 1u);
+                REQUIRE(queue.counters()->dropped == 0u);
+            }
+        }
+    }
+
+    GIVEN("a deadline queue which drops late values") {
+        concurrent::unsafe_deadline_queue<int> queue(concurrent::missed_deadline_policy::drop);
+
+        WHEN("values with passed deadlines are pushed") {
+            queue.emplace(passed, 0);
+            queue.emplace(future, 1);
+            queue.emplace(passed, 2);
+
+            THEN("they're removed without being popped") {
+                REQUIRE(queue.size() == 3u);
+                REQUIRE(queue.remove_expired());
+                REQUIRE(queue.size() == 1u);
+                REQUIRE(queue.pop() == 1);
+                REQUIRE(queue.empty());
+                REQUIRE(queue.counters()->missed == 2u);
+                REQUIRE(queue.counters()->dropped == 2u);
+            }
+        }
+    }
+
+    GIVEN("a deadline queue which diverts late values") {
+        std::vector<int> diverted;
+        concurrent::unsafe_deadline_queue<int> queue(
+                concurrent::missed_deadline_policy::divert,
+                std::make_shared<concurrent::deadline_counters>(),
+                [&diverted](int value) { diverted.push_back(value); }
+        );
+
+        WHEN("a value with passed deadline is pushed") {
+            queue.emplace(passed, 7);
+
+            THEN("it's passed to the handler when expired values are removed") {
+                REQUIRE_FALSE(queue.empty());
+                REQUIRE(diverted.empty());
+                REQUIRE(queue.remove_expired());
+                REQUIRE(queue.empty());
+                REQUIRE(diverted == std::vector<int>({7}));
+                REQUIRE(queue.counters()->dropped == 1u);
+            }
+        }
+    }
+}
+
+SCENARIO("running tasks by deadlines", "[concurrent::n_threaded_deadline_task_queue]") {
+    GIVEN("a 1-threaded deadline task queue dropping late tasks") {
+        const auto counters = std::make_shared<concurrent::deadline_counters>();
+        concurrent::n_threaded_deadline_task_queue task_queue(
+                1u,
+                concurrent::unsafe_deadline_queue<std::function<void()>>(
+                        concurrent::missed_deadline_policy::drop,
+                        counters
+                )
+        );
+
+        WHEN("tasks are pushed while the worker is busy") {
+            concurrent::latch release(1u);
+            std::mutex order_mutex;
+            std::vector<int> order;
+            const auto now = clock_type::now();
+
+            task_queue.push(std::make_pair(now + std::chrono::hours(1), [&release] { release.wait(); }));
+            for (int i: {3, 1, 2}) {
+                task_queue.push(std::make_pair(now + std::chrono::hours(i), [&order_mutex, &order, i] {
+                    std::lock_guard<std::mutex> lock(order_mutex);
+                    order.push_back(i);
+                }));
+            }
+            task_queue.push(std::make_pair(now - std::chrono::seconds(1), [&order_mutex, &order] {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(0);
+            }));
+            release.count_down();
+            task_queue.wait_for_tasks_completion();
+
+            THEN("they're run from the earliest deadline and late ones are dropped") {
+                REQUIRE(order == std::vector<int>({1, 2, 3}));
+                REQUIRE(counters->dropped == 1u);
+            }
+        }
+    }
+
+    GIVEN("a 4-threaded deadline task queue dropping late tasks") {
+        const auto counters = std::make_shared<concurrent::deadline_counters>();
+        concurrent::n_threaded_deadline_task_queue task_queue(
+                4u,
+                concurrent::unsafe_deadline_queue<std::function<void()>>(
+                        concurrent::missed_deadline_policy::drop,
+                        counters
+                )
+        );
+
+        WHEN("many tasks with deadlines passing while they're pushed are run") {
+            std::atomic<std::size_t> executed{0u};
+            for (int i = 0; i < 2000; ++i) {
+                task_queue.push(std::make_pair(
+                        clock_type::now() + std::chrono::microseconds(i % 20),
+                        [&executed] { ++executed; }
+                ));
+            }
+            task_queue.wait_for_tasks_completion();
+
+            THEN("each of them is either run or dropped") {
+                REQUIRE(executed + counters->dropped == 2000u);
+            }
+        }
+    }
+
+    GIVEN("a 1-threaded deadline task queue for 2 tasks dropping late tasks") {
+        const auto counters = std::make_shared<concurrent::deadline_counters>();
+        concurrent::n_threaded_deadline_task_queue task_queue(
+                1u,
+                concurrent::unsafe_deadline_queue<std::function<void()>>(
+                        concurrent::missed_deadline_policy::drop,
+                        counters
+                ),
+                concurrent::startup_policy::eager,
+                2u
+        );
+
+        WHEN("a push waits for room taken by tasks which become late") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            concurrent::latch pushed(1u);
+            const auto now = clock_type::now();
+
+            task_queue.push(std::make_pair(now + std::chrono::hours(1), [&started, &release] {
+                started.count_down();
+                release.wait();
+            }));
+            started.wait();
+            for (int i = 0; i < 2; ++i) {
+                task_queue.push(std::make_pair(now + std::chrono::milliseconds(1), [] {}));
+            }
+            std::thread pusher([&task_queue, &pushed] {
+                task_queue.push(std::make_pair(clock_type::now() + std::chrono::hours(1), [] {}));
+                pushed.count_down();
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            release.count_down();
+
+            THEN("dropping them wakes the waiting push") {
+                const auto woken = pushed.wait_for(config::default_timeout);
+                pusher.join();
+                REQUIRE(woken);
+                task_queue.wait_for_tasks_completion();
+                REQUIRE(counters->dropped == 2u);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <catch.hpp>
+#include <task_queues.hpp>
+#include <unsafe_indexed_priority_queue.hpp>
+#include <latch.hpp>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+SCENARIO("changing priorities of queued values", "[concurrent::unsafe_indexed_priority_queue]") {
+    GIVEN("an indexed priority queue with three values") {
+        concurrent::unsafe_indexed_priority_queue<int, int> queue;
+        const auto low = queue.push_with_handle({0, 0});
+        const auto normal = queue.push_with_handle({1, 1});
+        const auto high = queue.push_with_handle({2, 2});
+
+        WHEN("priority of the lowest one is raised") {
+            REQUIRE(queue.update_priority(low, 3));
+
+            THEN("it's popped first") {
+                REQUIRE(queue.pop() == 0);
+                REQUIRE(queue.pop() == 2);
+                REQUIRE(queue.pop() == 1);
+            }
+        }
+
+        WHEN("priority of the highest one is lowered") {
+            REQUIRE(queue.update_priority(high, -1));
+
+            THEN("it's popped last") {
+                REQUIRE(queue.pop() == 1);
+                REQUIRE(queue.pop() == 0);
+                REQUIRE(queue.pop() == 2);
+            }
+        }
+
+        WHEN("one of them is erased") {
+            REQUIRE(queue.erase(normal));
+
+            THEN("the others are popped and its handle is invalid") {
+                REQUIRE(queue.size() == 2u);
+                REQUIRE(queue.pop() == 2);
+                REQUIRE(queue.pop() == 0);
+                REQUIRE_FALSE(queue.contains(normal));
+                REQUIRE_FALSE(queue.erase(normal));
+            }
+        }
+
+        WHEN("a value is popped and another one is pushed") {
+            REQUIRE(queue.pop() == 2);
+            const auto next = queue.push_with_handle({5, 5});
+
+            THEN("handle of the popped value doesn't point to the new one") {
+                REQUIRE_FALSE(queue.contains(high));
+                REQUIRE_FALSE(queue.update_priority(high, -5));
+                REQUIRE(queue.contains(next));
+                REQUIRE(queue.pop() == 5);
+            }
+        }
+
+        WHEN("the queue is cleared") {
+            queue.clear();
+
+            THEN("all handles are invalid") {
+                REQUIRE_FALSE(queue.contains(low));
+                REQUIRE_FALSE(queue.contains(normal));
+                REQUIRE_FALSE(queue.contains(high));
+            }
+        }
+    }
+}
+
+SCENARIO("reprioritizing queued tasks", "[concurrent::n_threaded_indexed_priority_task_queue]") {
+    GIVEN("a 1-threaded indexed priority task queue") {
+        concurrent::n_threaded_indexed_priority_task_queue task_queue(1u);
+
+        WHEN("tasks are reprioritized and erased while the worker is busy") {
+            concurrent::latch started(1u);
+            concurrent::latch release(1u);
+            std::mutex order_mutex;
+            std::vector<int> order;
+            const auto record = [&order_mutex, &order](int value) {
+                return [&order_mutex, &order, value] {
+                    std::lock_guard<std::mutex> lock(order_mutex);
+                    order.push_back(value);
+                };
+            };
+
+            task_queue.emplace(0, [&started, &release] {
+                started.count_down();
+                release.wait();
+            });
+            started.wait();
+
+            const auto first = task_queue.push_with_handle(std::make_pair(1, record(1)));
+            task_queue.push_with_handle(std::make_pair(2, record(2)));
+            const auto third = task_queue.push_with_handle(std::make_pair(3, record(3)));
+            const auto promoted = task_queue.update_priority(first, 10);
+            const auto erased = task_queue.erase(third);
+
+            release.count_down();
+            task_queue.wait_for_tasks_completion();
+
+            THEN("they're run in order of updated priorities") {
+                REQUIRE(promoted);
+                REQUIRE(erased);
+                REQUIRE(order == std::vector<int>({1, 2}));
+                REQUIRE_FALSE(task_queue.erase(first));
+            }
+        }
+    }
+}